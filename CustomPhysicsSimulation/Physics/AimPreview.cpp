@@ -0,0 +1,304 @@
+#include "AimPreview.h"
+#include "Sphere.h"
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+// Constructor for AimPreview
+AimPreview::AimPreview() : m_request({ 0.0f, 0.0f }), m_settings({ 0, 300, 2 }),
+    m_tableChanged(false), m_hasRequest(false), m_quit(false), m_generation(0), m_publishedGeneration(0),
+    m_tableGeneration(0), m_polledGeneration(0), m_stepStartVelocity(0), m_parkSpacing(0.0f) {
+    m_thread = std::thread(&AimPreview::run, this);
+}
+
+// Destructor for AimPreview
+AimPreview::~AimPreview() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        ++m_generation; // Cancel any prediction in flight
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+// Take a copy of the table to predict shots from
+void AimPreview::setTable(const PhysicsScene& scene) {
+    // Fill the staging table outside the lock; its arrays are reused, so this is a plain copy after the first table
+    Table& table = m_stagingTable;
+    scene.saveSnapshot(table.state);
+    const BallArrays& balls = scene.getBalls();
+    table.mass.resize(balls.size());
+    for (size_t i = 0; i < balls.size(); ++i) {
+        table.mass[i] = balls.handles[i]->getMass();
+    }
+    table.gravity = scene.getGravity();
+    table.timeStep = scene.getTimeStep();
+    table.solver = scene.getSolver();
+    table.deceleration = scene.getEventSolver().getDeceleration();
+    table.tableExtents = scene.getTableExtents();
+    table.pockets = scene.getPockets();
+    table.continuousCollision = scene.getContinuousCollision();
+    table.broadphase = scene.getBroadphase();
+    table.narrowphase = scene.getNarrowphase();
+    table.integrator = scene.getIntegrator();
+    table.sleepSpeed = scene.getSleepSpeed();
+
+    // Hand it over; the worker gets the new table and the render thread keeps the old arrays for next time
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::swap(m_stagingTable, m_pendingTable);
+    m_tableChanged = true;
+    m_hasRequest = false; // A request made for the old table means nothing on this one
+    m_tableGeneration = ++m_generation;
+}
+
+// Ask for the paths of a shot
+void AimPreview::request(const Shot& shot) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_request = shot;
+        m_hasRequest = true;
+        ++m_generation;
+    }
+    m_wake.notify_one();
+}
+
+// Set the slot of the cue ball
+void AimPreview::setCueBall(unsigned int index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_settings.cueBall = index;
+}
+
+// Set the most fixed steps a prediction runs
+void AimPreview::setMaxSteps(int maxSteps) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_settings.maxSteps = maxSteps;
+}
+
+// Set how many fixed steps apart the points of a path are
+void AimPreview::setSampleInterval(int interval) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_settings.sampleInterval = interval;
+}
+
+// Swap the newest finished prediction into path
+bool AimPreview::poll(AimPath& path) {
+    std::unique_lock<std::mutex> lock(m_resultMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return false;
+    }
+    if (m_publishedGeneration <= m_polledGeneration || m_publishedGeneration < m_tableGeneration) {
+        return false;
+    }
+    std::swap(path, m_published);
+    m_polledGeneration = m_publishedGeneration;
+    return true;
+}
+
+// Worker thread loop
+void AimPreview::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_quit || m_hasRequest; });
+        if (m_quit) {
+            return;
+        }
+
+        Shot shot = m_request;
+        Settings settings = m_settings;
+        unsigned int generation = m_generation.load();
+        m_hasRequest = false;
+        bool rebuild = m_tableChanged;
+        if (rebuild) {
+            std::swap(m_pendingTable, m_workTable);
+            m_tableChanged = false;
+        }
+        lock.unlock();
+
+        if (rebuild) {
+            buildScene();
+        }
+        if (predict(shot, settings, generation)) {
+            std::lock_guard<std::mutex> resultLock(m_resultMutex);
+            std::swap(m_published, m_workPath);
+            m_publishedGeneration = generation;
+        }
+
+        lock.lock();
+    }
+}
+
+// Build the worker's scene from the table
+void AimPreview::buildScene() {
+    const Table& table = m_workTable;
+    m_scene.reset(new PhysicsScene());
+    m_scene->setGravity(table.gravity);
+    m_scene->setTimeStep(table.timeStep);
+    m_scene->setSolver(table.solver);
+    m_scene->getEventSolver().setDeceleration(table.deceleration);
+    m_scene->setTableExtents(table.tableExtents);
+    for (const Pocket& pocket : table.pockets) {
+        m_scene->addPocket(pocket.position, pocket.radius);
+    }
+    m_scene->setContinuousCollision(table.continuousCollision);
+    m_scene->setBroadphase(table.broadphase);
+    m_scene->setNarrowphase(table.narrowphase);
+    m_scene->setIntegrator(table.integrator);
+    m_scene->setSleepSpeed(table.sleepSpeed);
+    m_scene->setKeepEvents(true); // The object ball is the first one the scene reports the cue ball colliding with
+
+    // Add a ball per slot; each prediction then restores the real state over them
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < table.state.size(); ++i) {
+        m_scene->addActor(new Sphere(glm::vec2(table.state.x[i], table.state.y[i]), glm::vec2(0),
+            table.mass[i], table.state.radius[i], glm::vec4(1, 1, 1, 1)));
+        maxRadius = std::max(maxRadius, table.state.radius[i]);
+    }
+    m_parkSpacing = maxRadius * 4.0f;
+}
+
+// Move a pocketed ball off the table and put it to sleep
+void AimPreview::parkBall(unsigned int index) {
+    glm::vec2 extents = m_scene->getTableExtents();
+    m_scene->getBalls().handles[index]->setPosition(glm::vec2(extents.x * 2.0f + m_parkSpacing, index * m_parkSpacing));
+    m_scene->sleepBall(index);
+}
+
+// Get the first ball the cue ball collided with during the last step
+int AimPreview::findObjectBall(unsigned int cueBall) const {
+    // Only contacts that were closing in are reported, in the order the step resolved them
+    for (const PhysicsEvent& event : m_scene->getEvents()) {
+        if (event.type != COLLISION_EVENT) continue;
+        if (event.ball == cueBall) return (int)event.other;
+        if (event.other == cueBall) return (int)event.ball;
+    }
+    return -1;
+}
+
+// Work out where the cue ball's centre was when it touched the object ball during the last step
+glm::vec2 AimPreview::findGhostBall(unsigned int cueBall, unsigned int objectBall) const {
+    const BallArrays& balls = m_scene->getBalls();
+    float startX = m_stepStartX[cueBall];
+    float startY = m_stepStartY[cueBall];
+    float offsetX = startX - m_stepStartX[objectBall];
+    float offsetY = startY - m_stepStartY[objectBall];
+    float contactDistance = balls.radius[cueBall] + balls.radius[objectBall];
+    float gapSquared = offsetX * offsetX + offsetY * offsetY - contactDistance * contactDistance;
+    if (gapSquared <= 0.0f) {
+        return glm::vec2(startX, startY); // Already touching when the step began
+    }
+
+    // Solve |start + direction * t - object| = contactDistance for the first t along the path
+    float speed = std::sqrt(m_stepStartVelocity.x * m_stepStartVelocity.x + m_stepStartVelocity.y * m_stepStartVelocity.y);
+    if (speed > 0.0f) {
+        float directionX = m_stepStartVelocity.x / speed;
+        float directionY = m_stepStartVelocity.y / speed;
+        float along = offsetX * directionX + offsetY * directionY;
+        float discriminant = along * along - gapSquared;
+        if (along < 0.0f && discriminant >= 0.0f) {
+            float t = -along - std::sqrt(discriminant);
+            return glm::vec2(startX + directionX * t, startY + directionY * t);
+        }
+    }
+
+    // The straight path misses (gravity bent it, or a cushion turned it within the step), so put the cue ball at the
+    // contact distance from the object ball on the side it bounced away to
+    float endX = balls.x[cueBall] - m_stepStartX[objectBall];
+    float endY = balls.y[cueBall] - m_stepStartY[objectBall];
+    float endDistance = std::sqrt(endX * endX + endY * endY);
+    if (endDistance == 0.0f) {
+        return glm::vec2(startX, startY);
+    }
+    float scale = contactDistance / endDistance;
+    return glm::vec2(m_stepStartX[objectBall] + endX * scale, m_stepStartY[objectBall] + endY * scale);
+}
+
+// Predict the paths of a shot
+bool AimPreview::predict(const Shot& shot, const Settings& settings, unsigned int generation) {
+    AimPath& path = m_workPath;
+    path.cueBall.clear();
+    path.objectBall.clear();
+    path.objectBallIndex = -1;
+    path.contactPosition = glm::vec2(0);
+    path.cueBallPocketed = false;
+    path.objectBallPocketed = false;
+    path.shot = shot;
+    unsigned int cueIndex = settings.cueBall;
+    if (!m_scene || cueIndex >= m_scene->getBalls().size()) {
+        return true;
+    }
+
+    m_scene->restoreSnapshot(m_workTable.state);
+    const BallArrays& balls = m_scene->getBalls();
+    Sphere* cueBall = balls.handles[cueIndex];
+    path.cueBall.push_back(cueBall->getPosition());
+    cueBall->applyForce(glm::vec2(std::cos(shot.angle), std::sin(shot.angle)) * shot.force);
+
+    bool cueDone = false;
+    bool objectDone = false;
+    int interval = std::max(settings.sampleInterval, 1);
+    for (int step = 1; step <= settings.maxSteps && !m_scene->allBallsStopped(); ++step) {
+        if (m_generation.load(std::memory_order_relaxed) != generation) {
+            return false;
+        }
+
+        // Until the cue ball hits something, remember where every ball was so the contact can be placed on its path
+        if (path.objectBallIndex < 0) {
+            m_stepStartX = balls.x;
+            m_stepStartY = balls.y;
+            m_stepStartVelocity = glm::vec2(balls.vx[cueIndex], balls.vy[cueIndex]);
+        }
+        m_scene->step(m_scene->getTimeStep());
+
+        if (path.objectBallIndex < 0) {
+            path.objectBallIndex = findObjectBall(cueIndex);
+            if (path.objectBallIndex >= 0) {
+                path.contactPosition = findGhostBall(cueIndex, path.objectBallIndex);
+                path.objectBall.push_back(glm::vec2(m_stepStartX[path.objectBallIndex], m_stepStartY[path.objectBallIndex]));
+            }
+        }
+
+        // Close off a path where its ball drops, before the ball is parked
+        for (Sphere* ball : m_scene->getPocketedBalls()) {
+            unsigned int index = ball->getBallIndex();
+            if (index == cueIndex && !cueDone) {
+                path.cueBall.push_back(ball->getPosition());
+                path.cueBallPocketed = true;
+                cueDone = true;
+            }
+            else if ((int)index == path.objectBallIndex && !objectDone) {
+                path.objectBall.push_back(ball->getPosition());
+                path.objectBallPocketed = true;
+                objectDone = true;
+            }
+            parkBall(index);
+        }
+
+        // A path ends where its ball comes to rest
+        bool cueStopped = !cueDone && balls.sleeping[cueIndex];
+        bool objectStopped = path.objectBallIndex >= 0 && !objectDone && balls.sleeping[path.objectBallIndex];
+        if (step % interval == 0 || cueStopped) {
+            if (!cueDone) path.cueBall.push_back(cueBall->getPosition());
+        }
+        if (step % interval == 0 || objectStopped) {
+            if (path.objectBallIndex >= 0 && !objectDone) {
+                path.objectBall.push_back(glm::vec2(balls.x[path.objectBallIndex], balls.y[path.objectBallIndex]));
+            }
+        }
+        cueDone |= cueStopped;
+        objectDone |= objectStopped;
+
+        if (cueDone && (path.objectBallIndex < 0 || objectDone)) {
+            return true;
+        }
+    }
+
+    // Cut off by the step limit: end each path where its ball got to
+    if (!cueDone) {
+        path.cueBall.push_back(cueBall->getPosition());
+    }
+    if (path.objectBallIndex >= 0 && !objectDone) {
+        path.objectBall.push_back(glm::vec2(balls.x[path.objectBallIndex], balls.y[path.objectBallIndex]));
+    }
+    return true;
+}
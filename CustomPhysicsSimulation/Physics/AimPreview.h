@@ -0,0 +1,126 @@
+#pragma once
+#include "glm/vec2.hpp"
+#include "PhysicsScene.h"
+#include "ShotEvaluator.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+
+// Predicted paths of the cue ball and the first object ball it hits, for one aim
+struct AimPath {
+    std::vector<glm::vec2> cueBall; // Positions of the cue ball along its path, starting where it rests
+    std::vector<glm::vec2> objectBall; // Positions of the first ball the cue ball hits, starting where it was hit (empty if it hits none)
+    int objectBallIndex; // Slot of the first ball hit, or -1 if the cue ball hits none
+    glm::vec2 contactPosition; // Where the cue ball's centre was when it touched that ball (the ghost ball)
+    bool cueBallPocketed; // Whether the cue ball path ends in a pocket
+    bool objectBallPocketed; // Whether the object ball path ends in a pocket
+    Shot shot; // Aim and force the paths were predicted for
+
+    AimPath() : objectBallIndex(-1), contactPosition(0), cueBallPocketed(false), objectBallPocketed(false), shot({ 0.0f, 0.0f }) {}
+};
+
+// Predicts where the cue ball and the first object ball will go, on a background thread, while the player aims.
+// setTable takes a copy of the table at rest; request asks for the paths of one aim and cancels whatever the worker
+// was predicting for the previous aim, and poll picks up the newest finished prediction. None of these wait for
+// the worker: the render thread only ever copies the table or swaps a finished path under a briefly held lock.
+// Only balls, pockets and settings are copied (the app's cushions are the table extents, not planes).
+class AimPreview
+{
+public:
+    AimPreview();
+    ~AimPreview();
+
+    AimPreview(const AimPreview&) = delete;
+    AimPreview& operator=(const AimPreview&) = delete;
+
+    // Takes a copy of the balls, pockets and settings of the scene (which should be at rest) to predict shots from.
+    // Predictions for an earlier table are cancelled and never returned by poll.
+    void setTable(const PhysicsScene& scene);
+    // Asks for the paths of a shot, cancelling any prediction still running for an earlier request
+    void request(const Shot& shot);
+    // Swaps the newest finished prediction for this table into path if there is one that has not been polled yet;
+    // returns false, leaving path alone, if there is none or the worker is publishing one right now
+    bool poll(AimPath& path);
+
+    // Sets the slot of the cue ball (the app adds the cue ball first, so this defaults to 0).
+    // Like the other settings, it is handed to the worker with the next request.
+    void setCueBall(unsigned int index);
+    // Sets the most fixed steps a prediction runs
+    void setMaxSteps(int maxSteps);
+    // Sets how many fixed steps apart the points of a path are
+    void setSampleInterval(int interval);
+
+private:
+    // Settings handed from the render thread to the worker with each request
+    struct Settings {
+        unsigned int cueBall; // Slot of the cue ball
+        int maxSteps; // Most fixed steps a prediction runs
+        int sampleInterval; // Fixed steps between path points
+    };
+
+    // Table handed from the render thread to the worker
+    struct Table {
+        SceneSnapshot state; // Ball state
+        std::vector<float> mass; // Mass of each ball slot
+        glm::vec2 gravity; // Gravity of the source scene
+        float timeStep; // Fixed step of the source scene
+        SolverType solver; // Solver of the source scene
+        float deceleration; // Rolling deceleration of the event-driven solver
+        glm::vec2 tableExtents; // Half extents of the table
+        std::vector<Pocket> pockets; // Pockets of the table
+        bool continuousCollision; // Whether balls are swept
+        BroadphaseType broadphase; // Broadphase of the source scene
+        NarrowphaseType narrowphase; // Narrowphase of the source scene
+        IntegratorType integrator; // Integrator of the source scene
+        float sleepSpeed; // Speed below which a ball falls asleep
+    };
+
+    // Worker thread loop: waits for a request and predicts it
+    void run();
+    // Builds the worker's scene from m_workTable
+    void buildScene();
+    // Predicts the paths of a shot into m_workPath; returns false if a newer request cancelled it
+    bool predict(const Shot& shot, const Settings& settings, unsigned int generation);
+    // Gets the first ball the cue ball collided with during the last step, or -1 if it hit none
+    int findObjectBall(unsigned int cueBall) const;
+    // Works out where the cue ball's centre was when it touched the object ball during the last step, by backing it
+    // up along its path from the start of the step to the contact distance from the object ball
+    glm::vec2 findGhostBall(unsigned int cueBall, unsigned int objectBall) const;
+    // Moves a pocketed ball off the table and puts it to sleep, so it plays no further part in the prediction
+    void parkBall(unsigned int index);
+
+    // Shared with the worker (guarded by m_mutex)
+    std::mutex m_mutex; // Guards the request, the settings and the pending table
+    std::condition_variable m_wake; // Wakes the worker for a new request or to quit
+    Shot m_request; // Newest requested shot
+    Settings m_settings; // Settings the next request is predicted with
+    Table m_pendingTable; // Newest table, not yet taken by the worker
+    bool m_tableChanged; // Whether m_pendingTable holds a table the worker has not taken
+    bool m_hasRequest; // Whether m_request has not been taken by the worker
+    bool m_quit; // Whether the worker should exit
+    std::atomic<unsigned int> m_generation; // Bumped by every request and table, so the worker can see it is out of date
+
+    // Finished prediction (guarded by m_resultMutex)
+    std::mutex m_resultMutex; // Guards m_published
+    AimPath m_published; // Newest finished prediction
+    unsigned int m_publishedGeneration; // Generation of m_published (0 when there is none)
+
+    // Render thread only
+    Table m_stagingTable; // Table being copied from the scene before it is handed over
+    unsigned int m_tableGeneration; // Generation at which the current table was handed over
+    unsigned int m_polledGeneration; // Generation of the last prediction returned by poll
+
+    // Worker only
+    Table m_workTable; // Table predictions start from
+    std::unique_ptr<PhysicsScene> m_scene; // Copy of the table the worker steps
+    AimPath m_workPath; // Prediction being built
+    std::vector<float> m_stepStartX; // Position x of every ball before the step being run, until the object ball is found
+    std::vector<float> m_stepStartY; // Position y of every ball before the step being run, until the object ball is found
+    glm::vec2 m_stepStartVelocity; // Velocity of the cue ball before the step being run
+    float m_parkSpacing; // Distance between parked balls
+
+    std::thread m_thread; // Worker thread (started last, so every member above exists before it runs)
+};
@@ -0,0 +1,143 @@
+#include "BallIntegrator.h"
+#include "PhysicsScene.h"
+#include "Simd.h"
+
+namespace {
+    // Pointers to the first ball of a batch
+    struct Batch {
+        float* x;
+        float* y;
+        float* vx;
+        float* vy;
+        float* previousX;
+        float* previousY;
+        const float* radius;
+        const unsigned char* sleeping;
+    };
+
+    // Staging for the last, partial batch so the kernels can always load and store a full register.
+    // Spare lanes are marked as sleeping, so they are left as they are.
+    struct TailBatch {
+        float x[simd::kWidth] = {}, y[simd::kWidth] = {}, vx[simd::kWidth] = {}, vy[simd::kWidth] = {};
+        float previousX[simd::kWidth] = {}, previousY[simd::kWidth] = {}, radius[simd::kWidth] = {};
+        unsigned char sleeping[simd::kWidth];
+
+        TailBatch(BallArrays& balls, size_t first, size_t lanes) {
+            for (int lane = 0; lane < simd::kWidth; ++lane) {
+                sleeping[lane] = 1;
+            }
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                x[lane] = balls.x[first + lane]; y[lane] = balls.y[first + lane];
+                vx[lane] = balls.vx[first + lane]; vy[lane] = balls.vy[first + lane];
+                previousX[lane] = balls.previousX[first + lane]; previousY[lane] = balls.previousY[first + lane];
+                radius[lane] = balls.radius[first + lane];
+                sleeping[lane] = balls.sleeping[first + lane];
+            }
+        }
+
+        Batch batch() { return { x, y, vx, vy, previousX, previousY, radius, sleeping }; }
+
+        void writeBack(BallArrays& balls, size_t first, size_t lanes) const {
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                balls.x[first + lane] = x[lane]; balls.y[first + lane] = y[lane];
+                balls.vx[first + lane] = vx[lane]; balls.vy[first + lane] = vy[lane];
+                balls.previousX[first + lane] = previousX[lane]; balls.previousY[first + lane] = previousY[lane];
+            }
+        }
+    };
+
+    Batch batchAt(BallArrays& balls, size_t first) {
+        return { &balls.x[first], &balls.y[first], &balls.vx[first], &balls.vy[first],
+            &balls.previousX[first], &balls.previousY[first], &balls.radius[first], &balls.sleeping[first] };
+    }
+
+    // Runs kernel over every full batch in one call, then over the staged tail.
+    // The kernel loops over count balls itself (count is a multiple of simd::kWidth) so its body stays one tight loop.
+    template <typename Kernel>
+    void forEachBatch(BallArrays& balls, Kernel kernel) {
+        size_t count = balls.size();
+        size_t fullCount = count - count % simd::kWidth;
+        if (fullCount > 0) {
+            kernel(batchAt(balls, 0), fullCount);
+        }
+        if (fullCount < count) {
+            TailBatch tail(balls, fullCount, count - fullCount);
+            kernel(tail.batch(), (size_t)simd::kWidth);
+            tail.writeBack(balls, fullCount, count - fullCount);
+        }
+    }
+}
+
+// Save previous positions, then integrate every awake ball
+void BallIntegrator::integrate(BallArrays& balls, glm::vec2 gravity, float dt) {
+    const simd::Float step = simd::broadcast(dt);
+    const simd::Float gravityStepX = simd::broadcast(gravity.x * dt);
+    const simd::Float gravityStepY = simd::broadcast(gravity.y * dt);
+
+    forEachBatch(balls, [&](Batch b, size_t count) {
+        for (size_t i = 0; i < count; i += simd::kWidth) {
+            simd::Mask sleeping = simd::loadFlags(b.sleeping + i);
+            simd::Float x = simd::load(b.x + i);
+            simd::Float y = simd::load(b.y + i);
+            simd::Float vx = simd::load(b.vx + i);
+            simd::Float vy = simd::load(b.vy + i);
+            simd::store(b.previousX + i, x);
+            simd::store(b.previousY + i, y);
+
+            simd::Float newVX = vx + gravityStepX;
+            simd::Float newVY = vy + gravityStepY;
+            simd::store(b.vx + i, simd::select(sleeping, vx, newVX));
+            simd::store(b.vy + i, simd::select(sleeping, vy, newVY));
+            simd::store(b.x + i, simd::select(sleeping, x, x + newVX * step));
+            simd::store(b.y + i, simd::select(sleeping, y, y + newVY * step));
+        }
+    });
+}
+
+// Damp every awake ball and bounce it off the table boundary
+void BallIntegrator::dampAndBounce(BallArrays& balls, glm::vec2 tableExtents, float friction, bool mirrorOvershoot) {
+    const simd::Float frictionCoefficient = simd::broadcast(friction);
+    const simd::Float two = simd::broadcast(2.0f);
+    const simd::Float minX = simd::broadcast(-tableExtents.x);
+    const simd::Float maxX = simd::broadcast(tableExtents.x);
+    const simd::Float minY = simd::broadcast(-tableExtents.y);
+    const simd::Float maxY = simd::broadcast(tableExtents.y);
+
+    // Bounces one axis: mirrors the overshoot if asked, then clamps, exactly as applyFrictionAndWalls does
+    auto bounceAxis = [&](simd::Float position, simd::Float radius, simd::Float low, simd::Float high, simd::Mask& hit) {
+        simd::Mask pastLow = position - radius < low;
+        hit = pastLow | (position + radius > high);
+        simd::Float result = position;
+        if (mirrorOvershoot) {
+            result = simd::select(pastLow, two * (low + radius) - result, two * (high - radius) - result);
+        }
+        result = simd::select(result - radius < low, low + radius, result);
+        result = simd::select(result + radius > high, high - radius, result);
+        return simd::select(hit, result, position);
+    };
+
+    forEachBatch(balls, [&](Batch b, size_t count) {
+        for (size_t i = 0; i < count; i += simd::kWidth) {
+            simd::Mask sleeping = simd::loadFlags(b.sleeping + i);
+            simd::Float x = simd::load(b.x + i);
+            simd::Float y = simd::load(b.y + i);
+            simd::Float vx = simd::load(b.vx + i);
+            simd::Float vy = simd::load(b.vy + i);
+            simd::Float radius = simd::load(b.radius + i);
+
+            simd::Mask hitX, hitY;
+            simd::Float newX = bounceAxis(x, radius, minX, maxX, hitX);
+            simd::Float newY = bounceAxis(y, radius, minY, maxY, hitY);
+
+            // A bounce replaces the damped velocity with the reflected pre-friction velocity
+            simd::Mask hit = hitX | hitY;
+            simd::Float newVX = simd::select(hit, simd::select(hitX, -vx, vx), vx * frictionCoefficient);
+            simd::Float newVY = simd::select(hit, simd::select(hitY, -vy, vy), vy * frictionCoefficient);
+
+            simd::store(b.x + i, simd::select(sleeping, x, newX));
+            simd::store(b.y + i, simd::select(sleeping, y, newY));
+            simd::store(b.vx + i, simd::select(sleeping, vx, newVX));
+            simd::store(b.vy + i, simd::select(sleeping, vy, newVY));
+        }
+    });
+}
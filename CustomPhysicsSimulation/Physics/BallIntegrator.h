@@ -0,0 +1,20 @@
+#pragma once
+#include "glm/vec2.hpp"
+
+struct BallArrays;
+
+// SIMD versions of the per-ball passes of a fixed step, run simd::kWidth balls at a time over the ball arrays.
+// Each lane performs the same float operations in the same order as PhysicsScene::integrateBalls and
+// PhysicsScene::applyFrictionAndWalls, which stay as the reference, so both produce bit-identical results.
+// Sleeping balls are masked off and left untouched.
+class BallIntegrator
+{
+public:
+    // Saves every ball's position as its previous position, then applies gravity to the velocity
+    // and velocity to the position of every awake ball
+    static void integrate(BallArrays& balls, glm::vec2 gravity, float dt);
+
+    // Damps the velocity of every awake ball by friction and bounces balls off the table boundary.
+    // With mirrorOvershoot, a ball past a cushion is reflected back onto the table rather than clamped.
+    static void dampAndBounce(BallArrays& balls, glm::vec2 tableExtents, float friction, bool mirrorOvershoot);
+};
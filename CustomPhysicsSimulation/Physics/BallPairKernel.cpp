@@ -0,0 +1,189 @@
+#include "BallPairKernel.h"
+#include "PhysicsScene.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+
+// Sort pairs into levels of pairs that share no ball
+void BallPairKernel::schedule(const std::vector<CandidatePair>& pairs, size_t ballCount) {
+    m_ballLevel.assign(ballCount, 0);
+    m_pairLevel.resize(pairs.size());
+
+    unsigned int levelCount = 0;
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        unsigned int level = std::max(m_ballLevel[pairs[k].a], m_ballLevel[pairs[k].b]);
+        m_pairLevel[k] = level;
+        m_ballLevel[pairs[k].a] = level + 1;
+        m_ballLevel[pairs[k].b] = level + 1;
+        levelCount = std::max(levelCount, level + 1);
+    }
+
+    // Counting sort by level, keeping the original order within a level
+    m_levelStart.assign(levelCount + 1, 0);
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        m_levelStart[m_pairLevel[k] + 1]++;
+    }
+    for (unsigned int l = 0; l < levelCount; ++l) {
+        m_levelStart[l + 1] += m_levelStart[l];
+    }
+    m_writeIndex.assign(m_levelStart.begin(), m_levelStart.end() - 1);
+    m_order.resize(pairs.size());
+    m_sortedPairs.resize(pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        unsigned int slot = m_writeIndex[m_pairLevel[k]]++;
+        m_order[slot] = (unsigned int)k;
+        m_sortedPairs[slot] = pairs[k];
+    }
+}
+
+// Resolve the scheduled pairs level by level
+void BallPairKernel::collide(BallArrays& balls, const std::vector<CandidatePair>& pairs, float dt, bool swept,
+    std::vector<unsigned char>& touched, ThreadPool* pool) {
+    const unsigned int W = simd::kWidth;
+    touched.assign(pairs.size(), 0);
+
+    for (size_t level = 0; level + 1 < m_levelStart.size(); ++level) {
+        unsigned int begin = m_levelStart[level];
+        unsigned int end = m_levelStart[level + 1];
+
+        // Pairs within a level share no ball, so any split of a level across threads gives the same result.
+        // Small levels are not worth the hand-off.
+        if (pool && pool->getThreadCount() > 1 && end - begin >= kMinParallelPairs) {
+            size_t batchCount = (end - begin + W - 1) / W;
+            pool->parallelFor(batchCount, kParallelGrain, [&](size_t firstBatch, size_t lastBatch) {
+                collideRange(balls, dt, swept, touched, begin + (unsigned int)firstBatch * W,
+                    std::min(end, begin + (unsigned int)lastBatch * W));
+            });
+        }
+        else {
+            collideRange(balls, dt, swept, touched, begin, end);
+        }
+    }
+}
+
+// Resolve a run of scheduled pairs from a single level, a SIMD batch at a time
+void BallPairKernel::collideRange(BallArrays& balls, float dt, bool swept, std::vector<unsigned char>& touched,
+    unsigned int begin, unsigned int end) {
+    const int W = simd::kWidth;
+    unsigned int ballI[W], ballJ[W];
+    float laneX[W], laneY[W], laneVX[W], laneVY[W];
+
+    const float restitution = 0.8f;
+    const simd::Float bounce = simd::broadcast(-(1.0f + restitution));
+    const simd::Float zero = simd::broadcast(0.0f);
+    const simd::Float half = simd::broadcast(0.5f);
+    const simd::Float two = simd::broadcast(2.0f);
+    const simd::Float four = simd::broadcast(4.0f);
+    const simd::Float step = simd::broadcast(dt);
+
+    for (unsigned int first = begin; first < end; first += W) {
+        int lanes = (int)std::min<unsigned int>(W, end - first);
+
+        // Spare lanes repeat the first pair and are never written back
+        for (int lane = 0; lane < W; ++lane) {
+            const CandidatePair& pair = m_sortedPairs[first + (lane < lanes ? lane : 0)];
+            ballI[lane] = pair.a;
+            ballJ[lane] = pair.b;
+        }
+
+        simd::Float posXI = simd::gather(balls.x.data(), ballI), posYI = simd::gather(balls.y.data(), ballI);
+        simd::Float posXJ = simd::gather(balls.x.data(), ballJ), posYJ = simd::gather(balls.y.data(), ballJ);
+        simd::Float contactDistance = simd::gather(balls.radius.data(), ballI) + simd::gather(balls.radius.data(), ballJ);
+
+        // Discrete overlap test, the same operations as PhysicsScene::ball2Ball
+        simd::Float deltaX = posXJ - posXI;
+        simd::Float deltaY = posYJ - posYI;
+        simd::Float distance = simd::sqrt(deltaX * deltaX + deltaY * deltaY);
+        simd::Float intersection = contactDistance - distance;
+        simd::Mask overlap = intersection > zero;
+        simd::Mask discrete = overlap;
+        simd::Mask impact = simd::broadcast(1.0f) < zero;
+        if (!swept && (simd::bits(overlap) & ((1 << lanes) - 1)) == 0) {
+            continue;
+        }
+
+        simd::Float velXI = simd::gather(balls.vx.data(), ballI), velYI = simd::gather(balls.vy.data(), ballI);
+        simd::Float velXJ = simd::gather(balls.vx.data(), ballJ), velYJ = simd::gather(balls.vy.data(), ballJ);
+        simd::Float relativeVelocityX = velXJ - velXI;
+        simd::Float relativeVelocityY = velYJ - velYI;
+
+        // Swept time of impact, the same operations as PhysicsScene::sweptBall2Ball
+        simd::Float startGapX, startGapY, timeOfImpact;
+        if (swept) {
+            startGapX = deltaX - relativeVelocityX * step;
+            startGapY = deltaY - relativeVelocityY * step;
+            simd::Float a = relativeVelocityX * relativeVelocityX + relativeVelocityY * relativeVelocityY;
+            simd::Float b = two * (startGapX * relativeVelocityX + startGapY * relativeVelocityY);
+            simd::Float c = startGapX * startGapX + startGapY * startGapY - contactDistance * contactDistance;
+            simd::Float discriminant = b * b - four * a * c;
+            simd::Mask fallback = (c <= zero) | (a == zero) | (b >= zero) | (discriminant < zero);
+            timeOfImpact = (-b - simd::sqrt(discriminant)) / (two * a);
+            impact = ~fallback & ~(timeOfImpact > step);
+            discrete = fallback & overlap;
+        }
+
+        // Most batches touch nothing, so skip the response entirely
+        int hitBits = simd::bits(impact | discrete) & ((1 << lanes) - 1);
+        if (hitBits == 0) {
+            continue;
+        }
+
+        simd::Float imI = simd::gather(balls.invMass.data(), ballI);
+        simd::Float imJ = simd::gather(balls.invMass.data(), ballJ);
+        simd::Float invMassSum = imI + imJ;
+
+        // Discrete response
+        simd::Float normalX = deltaX / distance;
+        simd::Float normalY = deltaY / distance;
+        simd::Float impulseMagnitude = (bounce * (relativeVelocityX * normalX + relativeVelocityY * normalY)) / invMassSum;
+        simd::Float impulseX = impulseMagnitude * normalX;
+        simd::Float impulseY = impulseMagnitude * normalY;
+        simd::Float separationX = normalX * intersection * half;
+        simd::Float separationY = normalY * intersection * half;
+        simd::Float outVelXI = simd::select(discrete, velXI - impulseX * imI, velXI);
+        simd::Float outVelYI = simd::select(discrete, velYI - impulseY * imI, velYI);
+        simd::Float outVelXJ = simd::select(discrete, velXJ + impulseX * imJ, velXJ);
+        simd::Float outVelYJ = simd::select(discrete, velYJ + impulseY * imJ, velYJ);
+        simd::Float outPosXI = simd::select(discrete, posXI - separationX, posXI);
+        simd::Float outPosYI = simd::select(discrete, posYI - separationY, posYI);
+        simd::Float outPosXJ = simd::select(discrete, posXJ + separationX, posXJ);
+        simd::Float outPosYJ = simd::select(discrete, posYJ + separationY, posYJ);
+
+        // Swept response: rewind to the impact, bounce, and move on for the rest of the step
+        if (swept && simd::bits(impact)) {
+            simd::Float remaining = step - timeOfImpact;
+            simd::Float sweptNormalX = (startGapX + relativeVelocityX * timeOfImpact) / contactDistance;
+            simd::Float sweptNormalY = (startGapY + relativeVelocityY * timeOfImpact) / contactDistance;
+            simd::Float sweptMagnitude = (bounce * (relativeVelocityX * sweptNormalX + relativeVelocityY * sweptNormalY)) / invMassSum;
+            simd::Float sweptImpulseX = sweptMagnitude * sweptNormalX;
+            simd::Float sweptImpulseY = sweptMagnitude * sweptNormalY;
+            simd::Float newVelXI = velXI - sweptImpulseX * imI;
+            simd::Float newVelYI = velYI - sweptImpulseY * imI;
+            simd::Float newVelXJ = velXJ + sweptImpulseX * imJ;
+            simd::Float newVelYJ = velYJ + sweptImpulseY * imJ;
+            outVelXI = simd::select(impact, newVelXI, outVelXI);
+            outVelYI = simd::select(impact, newVelYI, outVelYI);
+            outVelXJ = simd::select(impact, newVelXJ, outVelXJ);
+            outVelYJ = simd::select(impact, newVelYJ, outVelYJ);
+            outPosXI = simd::select(impact, (posXI - velXI * remaining) + newVelXI * remaining, outPosXI);
+            outPosYI = simd::select(impact, (posYI - velYI * remaining) + newVelYI * remaining, outPosYI);
+            outPosXJ = simd::select(impact, (posXJ - velXJ * remaining) + newVelXJ * remaining, outPosXJ);
+            outPosYJ = simd::select(impact, (posYJ - velYJ * remaining) + newVelYJ * remaining, outPosYJ);
+        }
+
+        // Scatter only the lanes that made contact
+        simd::store(laneX, outPosXI); simd::store(laneY, outPosYI); simd::store(laneVX, outVelXI); simd::store(laneVY, outVelYI);
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (!(hitBits & (1 << lane))) continue;
+            unsigned int i = ballI[lane];
+            balls.x[i] = laneX[lane]; balls.y[i] = laneY[lane]; balls.vx[i] = laneVX[lane]; balls.vy[i] = laneVY[lane];
+            touched[m_order[first + lane]] = 1;
+        }
+        simd::store(laneX, outPosXJ); simd::store(laneY, outPosYJ); simd::store(laneVX, outVelXJ); simd::store(laneVY, outVelYJ);
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (!(hitBits & (1 << lane))) continue;
+            unsigned int j = ballJ[lane];
+            balls.x[j] = laneX[lane]; balls.y[j] = laneY[lane]; balls.vx[j] = laneVX[lane]; balls.vy[j] = laneVY[lane];
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "SpatialGrid.h"
+#include <vector>
+#include <cstddef>
+
+struct BallArrays;
+class ThreadPool;
+
+// SIMD narrowphase for candidate ball pairs.
+// Pairs are first sorted into levels: a pair's level is one past the highest level of any earlier pair
+// sharing a ball with it, so pairs within a level never share a ball and everything a pair depends on
+// sits in a lower level. Each level is then resolved simd::kWidth pairs at a time. Because every lane
+// performs the same float operations in the same order as PhysicsScene::ball2Ball / sweptBall2Ball,
+// the result is bit-identical to resolving the pairs one by one in their original order.
+class BallPairKernel
+{
+public:
+    // Sorts pairs into levels of pairs that share no ball
+    void schedule(const std::vector<CandidatePair>& pairs, size_t ballCount);
+
+    // Resolves the scheduled pairs, swept over dt or discrete, setting touched[k] for every pair k that made contact.
+    // With a pool, large levels are split across its threads; the result does not depend on the thread count.
+    void collide(BallArrays& balls, const std::vector<CandidatePair>& pairs, float dt, bool swept,
+        std::vector<unsigned char>& touched, ThreadPool* pool = nullptr);
+
+    // Gets the number of levels produced by the last schedule
+    size_t getLevelCount() const { return m_levelStart.empty() ? 0 : m_levelStart.size() - 1; }
+
+private:
+    static const unsigned int kMinParallelPairs = 1024; // Smallest level worth splitting across threads
+    static const size_t kParallelGrain = 32; // SIMD batches handed to a thread at a time
+
+    // Resolves scheduled pairs [begin, end), which must all be in one level
+    void collideRange(BallArrays& balls, float dt, bool swept, std::vector<unsigned char>& touched,
+        unsigned int begin, unsigned int end);
+
+    std::vector<unsigned int> m_ballLevel; // Next free level of each ball while scheduling
+    std::vector<unsigned int> m_pairLevel; // Level of each pair
+    std::vector<unsigned int> m_levelStart; // Start of each level in m_order (level count + 1 entries)
+    std::vector<unsigned int> m_writeIndex; // Next free slot of each level in m_order while scheduling
+    std::vector<unsigned int> m_order; // Pair indices sorted by level, original order within a level
+    std::vector<CandidatePair> m_sortedPairs; // The pairs themselves in m_order, so batches read them contiguously
+};
@@ -0,0 +1,173 @@
+#include "EventLog.h"
+#include <iostream>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+
+namespace {
+
+// Identifies a binary event log
+const char kMagic[4] = { 'B', 'P', 'E', 'V' };
+// Binary format version
+const uint32_t kVersion = 1;
+// Bytes one event takes in a binary log
+const uint32_t kRecordSize = 32;
+// How long the writer sleeps when the ring is empty
+const std::chrono::milliseconds kPollInterval(2);
+// Formatted events are written out once this many bytes have built up
+const size_t kFlushSize = 1 << 16;
+
+// Names of the cushions, by index
+const char* const kCushionNames[4] = { "left", "right", "bottom", "top" };
+
+}
+
+// Constructor for EventLog
+EventLog::EventLog() : m_capacity(1 << 14), m_mask(0), m_head(0), m_cachedTail(0), m_droppedCount(0), m_tail(0),
+    m_format(EVENT_LOG_BINARY), m_closing(false) {
+}
+
+// Destructor for EventLog
+EventLog::~EventLog() {
+    close();
+}
+
+// Start a log at path
+bool EventLog::open(const std::string& path, EventLogFormat format) {
+    close();
+    m_file.open(path, format == EVENT_LOG_BINARY ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+    if (!m_file.is_open()) {
+        std::cerr << "Failed to create event log " << path << std::endl;
+        return false;
+    }
+    m_format = format;
+    m_buffer.clear();
+    m_buffer.reserve(kFlushSize + 256);
+    if (format == EVENT_LOG_BINARY) {
+        unsigned char header[16] = {};
+        std::memcpy(header, kMagic, 4);
+        std::memcpy(header + 4, &kVersion, 4);
+        std::memcpy(header + 8, &kRecordSize, 4);
+        m_buffer.insert(m_buffer.end(), header, header + sizeof(header));
+    }
+
+    // Index the ring with a mask, so it must be a power of two
+    size_t size = 1;
+    while (size < m_capacity) {
+        size <<= 1;
+    }
+    m_mask = size - 1;
+    m_head = 0;
+    m_tail = 0;
+    m_cachedTail = 0;
+    m_droppedCount = 0;
+    m_closing = false;
+    m_ring.reset(new PhysicsEvent[size]);
+    m_writer = std::thread(&EventLog::run, this);
+    return true;
+}
+
+// Write every pushed event and close the file
+void EventLog::close() {
+    if (!m_ring) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    m_file.close();
+    if (m_droppedCount > 0) {
+        std::cerr << "Event log dropped " << m_droppedCount << " events (the ring was full)" << std::endl;
+    }
+    m_ring.reset();
+}
+
+// Writer thread loop
+void EventLog::run() {
+    while (true) {
+        // Read the flag before draining, so everything pushed before close is drained on the last pass
+        bool closing;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            closing = m_closing;
+        }
+        if (!drain()) {
+            flush();
+            if (closing) {
+                break;
+            }
+            // The pushing thread never signals (that could block it), so poll while the ring is empty
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait_for(lock, kPollInterval, [this] { return m_closing; });
+        }
+    }
+}
+
+// Format every event in the ring
+bool EventLog::drain() {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    size_t head = m_head.load(std::memory_order_acquire);
+    if (tail == head) {
+        return false;
+    }
+    for (; tail != head; ++tail) {
+        format(m_ring[tail & m_mask]);
+        if (m_buffer.size() >= kFlushSize) {
+            // Give the slots back before the slow part, so the ring has room while the file is written
+            m_tail.store(tail + 1, std::memory_order_release);
+            flush();
+        }
+    }
+    m_tail.store(tail, std::memory_order_release);
+    return true;
+}
+
+// Append one event to the buffer
+void EventLog::format(const PhysicsEvent& event) {
+    if (m_format == EVENT_LOG_BINARY) {
+        unsigned char record[kRecordSize] = {};
+        std::memcpy(record, &event.time, 8);
+        record[8] = (unsigned char)event.type;
+        std::memcpy(record + 12, &event.ball, 4);
+        std::memcpy(record + 16, &event.other, 4);
+        std::memcpy(record + 20, &event.x, 4);
+        std::memcpy(record + 24, &event.y, 4);
+        std::memcpy(record + 28, &event.speed, 4);
+        m_buffer.insert(m_buffer.end(), record, record + kRecordSize);
+        return;
+    }
+
+    char line[256];
+    int length = 0;
+    switch (event.type) {
+    case COLLISION_EVENT:
+        length = std::snprintf(line, sizeof(line), "{\"time\":%.6f,\"type\":\"collision\",\"ball\":%u,\"other\":%u,",
+            event.time, event.ball, event.other);
+        break;
+    case CUSHION_EVENT:
+        length = std::snprintf(line, sizeof(line), "{\"time\":%.6f,\"type\":\"cushion\",\"ball\":%u,\"cushion\":\"%s\",",
+            event.time, event.ball, kCushionNames[event.other & 3]);
+        break;
+    default:
+        length = std::snprintf(line, sizeof(line), "{\"time\":%.6f,\"type\":\"pocket\",\"ball\":%u,\"pocket\":%u,",
+            event.time, event.ball, event.other);
+        break;
+    }
+    length += std::snprintf(line + length, sizeof(line) - length, "\"x\":%.9g,\"y\":%.9g,\"speed\":%.9g}\n",
+        event.x, event.y, event.speed);
+    m_buffer.insert(m_buffer.end(), line, line + length);
+}
+
+// Write the buffer out to the file
+void EventLog::flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    m_file.write(m_buffer.data(), (std::streamsize)m_buffer.size());
+    m_file.flush();
+    m_buffer.clear();
+}
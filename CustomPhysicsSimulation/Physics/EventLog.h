@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+// Kinds of event a scene reports to its event log
+enum PhysicsEventType : uint32_t {
+    COLLISION_EVENT = 0, // Two balls touched (other = the second ball's slot)
+    CUSHION_EVENT,       // A ball bounced off a cushion (other = 0 left, 1 right, 2 bottom, 3 top)
+    POCKET_EVENT         // A ball dropped into a pocket (other = the pocket's index)
+};
+
+// One contact reported by a scene. Balls are named by their slot in the scene's ball arrays at the time of the
+// event, the same numbering a replay uses.
+struct PhysicsEvent {
+    double time;           // Simulation time of the event, in seconds since the scene was created
+    PhysicsEventType type; // What happened
+    uint32_t ball;         // Slot of the ball
+    uint32_t other;        // Second ball, cushion or pocket, depending on type
+    float x;               // Where it happened, x (the contact point, for two balls)
+    float y;               // Where it happened, y
+    float speed;           // Closing speed along the contact normal (collisions and cushions) or ball speed (pockets)
+};
+
+// File format written by an event log
+enum EventLogFormat {
+    EVENT_LOG_BINARY = 0, // 16-byte header ("BPEV", version, record size), then one 32-byte little-endian record per event
+    EVENT_LOG_JSONL       // One JSON object per line
+};
+
+// Streams the events of a scene to a file. Attach it with PhysicsScene::setEventLog and the scene pushes every
+// collision, cushion bounce and pocket into a fixed-size single-producer ring while it steps. Pushing is a copy
+// and two atomic operations and never waits: when the ring is full the event is dropped and counted instead.
+// A background thread drains the ring, formats the events and writes them out.
+class EventLog
+{
+public:
+    EventLog();
+    ~EventLog();
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    // Sets how many events the ring holds (rounded up to a power of two); used by the next open
+    void setCapacity(size_t capacity) { m_capacity = capacity; }
+
+    // Starts a log at path, replacing any file there; returns false if it cannot be created
+    bool open(const std::string& path, EventLogFormat format);
+    // Waits for every pushed event to be written and closes the file. Call it from the thread that pushes.
+    void close();
+    // Gets whether a log is being written
+    bool isOpen() const { return m_ring != nullptr; }
+
+    // Queues an event for writing; returns false (and counts the event as dropped) if the ring is full.
+    // Only one thread may push at a time.
+    bool push(const PhysicsEvent& event) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_cachedTail > m_mask) {
+            // Only look at the writer's position again once the ring looks full, so most pushes touch no shared line
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head - m_cachedTail > m_mask) {
+                m_droppedCount.store(m_droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_ring[head & m_mask] = event;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Gets the number of events pushed since open, including dropped ones
+    uint64_t getEventCount() const { return m_head.load(std::memory_order_relaxed) + getDroppedCount(); }
+    // Gets the number of events dropped since open because the ring was full
+    uint64_t getDroppedCount() const { return m_droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    // Writer thread loop: drains the ring until the log is closed
+    void run();
+    // Formats every event in the ring into m_buffer, writing it out as it fills; returns false if the ring was empty
+    bool drain();
+    // Appends one event to m_buffer in the log's format
+    void format(const PhysicsEvent& event);
+    // Writes m_buffer out to the file
+    void flush();
+
+    size_t m_capacity; // Events the next ring will hold
+    std::unique_ptr<PhysicsEvent[]> m_ring; // Events waiting to be written
+    size_t m_mask; // Ring size minus one
+
+    // Pushing thread
+    alignas(64) std::atomic<size_t> m_head; // Events pushed since open (the next slot is m_head & m_mask)
+    size_t m_cachedTail; // Last m_tail seen by the pushing thread
+    std::atomic<uint64_t> m_droppedCount; // Events dropped because the ring was full
+
+    // Writer thread
+    alignas(64) std::atomic<size_t> m_tail; // Events written since open
+    std::thread m_writer; // Thread that drains the ring
+    std::ofstream m_file; // File being written (only touched by the writer while it runs)
+    EventLogFormat m_format; // Format of the file
+    std::vector<char> m_buffer; // Formatted events not yet written out
+
+    std::mutex m_mutex; // Guards the writer's sleep
+    std::condition_variable m_wake; // Wakes the writer to finish
+    bool m_closing; // Whether the writer should drain the ring and exit
+};
@@ -0,0 +1,465 @@
+#include "EventSolver.h"
+#include "PhysicsScene.h"
+#include "EventLog.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+    // Upper bound on the events processed in one advance, so a degenerate cluster cannot hang a frame
+    const size_t kMaxEventsPerAdvance = 100000;
+
+    // Coefficient of restitution for ball-ball contacts (matches PhysicsScene::ball2Ball)
+    const double kRestitution = 0.8;
+
+    // Contacts due within this many seconds of now count as immediate
+    const double kContactEpsilon = 1e-9;
+
+    // Evaluates a polynomial whose coefficients are stored lowest order first
+    double evaluate(const double* c, int degree, double t) {
+        double result = c[degree];
+        for (int k = degree - 1; k >= 0; --k) {
+            result = result * t + c[k];
+        }
+        return result;
+    }
+
+    // Bisects [lo, hi] for the sign change of a polynomial, returning the end on the far side of the root
+    double bisect(const double* c, int degree, double lo, double hi) {
+        bool positiveAtLo = evaluate(c, degree, lo) > 0.0;
+        for (int iteration = 0; iteration < 100 && hi - lo > 1e-12; ++iteration) {
+            double mid = 0.5 * (lo + hi);
+            if ((evaluate(c, degree, mid) > 0.0) == positiveAtLo) {
+                lo = mid;
+            }
+            else {
+                hi = mid;
+            }
+        }
+        return hi;
+    }
+
+    // Appends the roots of a polynomial of degree 3 or lower that lie strictly inside (lo, hi), in ascending order
+    void findRoots(const double* c, int degree, double lo, double hi, std::vector<double>& roots) {
+        while (degree > 0 && c[degree] == 0.0) {
+            degree--;
+        }
+        if (degree == 0) {
+            return;
+        }
+        if (degree == 1) {
+            double root = -c[0] / c[1];
+            if (root > lo && root < hi) {
+                roots.push_back(root);
+            }
+            return;
+        }
+
+        // Split the range at the turning points so the polynomial is monotonic on each piece
+        double derivative[3];
+        for (int k = 1; k <= degree; ++k) {
+            derivative[k - 1] = c[k] * k;
+        }
+        std::vector<double> turningPoints;
+        findRoots(derivative, degree - 1, lo, hi, turningPoints);
+        turningPoints.push_back(hi);
+
+        double start = lo;
+        for (double end : turningPoints) {
+            if ((evaluate(c, degree, start) > 0.0) != (evaluate(c, degree, end) > 0.0)) {
+                double root = bisect(c, degree, start, end);
+                if (root < hi) {
+                    roots.push_back(root);
+                }
+            }
+            start = end;
+        }
+    }
+
+    // Finds the first time in [0, window] at which a polynomial drops to zero or below.
+    // If it is already non-positive at 0 (e.g. balls placed slightly overlapping), contact is immediate when
+    // allowInside is set or it is still falling; otherwise contact is the first time it falls below its current value.
+    // Returns a negative value when there is no such time.
+    double firstContact(double* c, int degree, double window, bool allowInside) {
+        while (degree > 0 && c[degree] == 0.0) {
+            degree--;
+        }
+        if (c[0] <= 0.0) {
+            if (allowInside || (degree > 0 && c[1] < 0.0)) {
+                return 0.0;
+            }
+            c[0] = 1e-9;
+        }
+        if (degree == 0) {
+            return -1.0;
+        }
+
+        // Between turning points the polynomial is monotonic, so the first piece that ends
+        // non-positive contains the first contact
+        std::vector<double> points;
+        if (degree >= 2) {
+            double derivative[4];
+            for (int k = 1; k <= degree; ++k) {
+                derivative[k - 1] = c[k] * k;
+            }
+            findRoots(derivative, degree - 1, 0.0, window, points);
+        }
+        points.push_back(window);
+
+        double start = 0.0;
+        for (double end : points) {
+            if (evaluate(c, degree, end) <= 0.0) {
+                return bisect(c, degree, start, end);
+            }
+            start = end;
+        }
+        return -1.0;
+    }
+
+    // Builds |a + b t + c t^2|^2 - radius^2 as a quartic, lowest order first
+    void distanceQuartic(double ax, double ay, double bx, double by, double cx, double cy, double radius, double* out) {
+        out[0] = ax * ax + ay * ay - radius * radius;
+        out[1] = 2.0 * (ax * bx + ay * by);
+        out[2] = bx * bx + by * by + 2.0 * (ax * cx + ay * cy);
+        out[3] = 2.0 * (bx * cx + by * cy);
+        out[4] = cx * cx + cy * cy;
+    }
+}
+
+// Constructor for EventSolver
+EventSolver::EventSolver() : m_balls(nullptr), m_pockets(nullptr), m_tableExtents(100, 50),
+    m_time(0.0), m_eventSequence(0), m_valid(false), m_deceleration(200.0f),
+    m_restingSpeed(0.01f), m_eventCount(0) {
+}
+
+// Discard every prediction so they are rebuilt on the next advance
+void EventSolver::reset() {
+    m_valid = false;
+}
+
+// Set the rolling deceleration, kept positive so every trajectory comes to rest in finite time
+void EventSolver::setDeceleration(float deceleration) {
+    m_deceleration = std::max(deceleration, 0.001f);
+}
+
+// Flag a ball whose state was changed from outside the solver
+void EventSolver::markBallChanged(unsigned int index) {
+    if (m_valid) {
+        m_changed.push_back(index);
+    }
+}
+
+// Rebuild the per-ball bookkeeping and predict an event for every ball
+void EventSolver::rebuild() {
+    size_t count = m_balls->size();
+    m_referenceTime.assign(count, m_time);
+    m_version.assign(count, 0);
+    m_nextEvent.assign(count, 0);
+    m_inPocket.assign(count, 0);
+    m_changed.clear();
+    m_events = std::priority_queue<Event, std::vector<Event>, std::greater<Event>>();
+
+    for (unsigned int i = 0; i < count; ++i) {
+        predict(i);
+    }
+    m_valid = true;
+}
+
+// Move a ball along its trajectory to time t
+void EventSolver::moveBall(unsigned int index, double t) {
+    double tau = t - m_referenceTime[index];
+    m_referenceTime[index] = t;
+    if (tau <= 0.0) {
+        return;
+    }
+
+    BallArrays& balls = *m_balls;
+    double vx = balls.vx[index];
+    double vy = balls.vy[index];
+    double speed = std::sqrt(vx * vx + vy * vy);
+    if (speed == 0.0) {
+        return;
+    }
+
+    // Decelerate along the direction of travel until the ball stops
+    double stopTau = speed / m_deceleration;
+    double moveTau = std::min(tau, stopTau);
+    double ax = -m_deceleration * vx / speed;
+    double ay = -m_deceleration * vy / speed;
+    balls.x[index] = (float)(balls.x[index] + vx * moveTau + 0.5 * ax * moveTau * moveTau);
+    balls.y[index] = (float)(balls.y[index] + vy * moveTau + 0.5 * ay * moveTau * moveTau);
+    if (moveTau >= stopTau) {
+        balls.vx[index] = 0.0f;
+        balls.vy[index] = 0.0f;
+    }
+    else {
+        balls.vx[index] = (float)(vx + ax * moveTau);
+        balls.vy[index] = (float)(vy + ay * moveTau);
+    }
+}
+
+// Predict the earliest event for a ball from the current time and queue it
+void EventSolver::predict(unsigned int index, unsigned int resolvedWith) {
+    if (m_inPocket[index]) {
+        return;
+    }
+
+    BallArrays& balls = *m_balls;
+    moveBall(index, m_time);
+
+    double x = balls.x[index];
+    double y = balls.y[index];
+    double vx = balls.vx[index];
+    double vy = balls.vy[index];
+    double radius = balls.radius[index];
+    double speed = std::sqrt(vx * vx + vy * vy);
+    bool moving = speed > 0.0;
+
+    // Half the acceleration, i.e. the t^2 coefficient of the trajectory
+    double halfAx = moving ? -0.5 * m_deceleration * vx / speed : 0.0;
+    double halfAy = moving ? -0.5 * m_deceleration * vy / speed : 0.0;
+    double stopTau = moving ? speed / m_deceleration : 0.0;
+
+    Event best = { INFINITY, BALL_STOP, index, 0, m_version[index], 0, 0 };
+    double coefficients[5];
+
+    if (moving) {
+        best.time = m_time + stopTau;
+
+        // Cushions: the distance to each wall is a quadratic in time
+        double wallGap[4] = {
+            x - (-m_tableExtents.x + radius), (m_tableExtents.x - radius) - x,
+            y - (-m_tableExtents.y + radius), (m_tableExtents.y - radius) - y
+        };
+        for (unsigned int cushion = 0; cushion < 4; ++cushion) {
+            double sign = (cushion % 2 == 0) ? 1.0 : -1.0;
+            double velocity = cushion < 2 ? vx : vy;
+            double halfAcceleration = cushion < 2 ? halfAx : halfAy;
+            coefficients[0] = wallGap[cushion];
+            coefficients[1] = sign * velocity;
+            coefficients[2] = sign * halfAcceleration;
+            double tau = firstContact(coefficients, 2, stopTau, false);
+            if (tau >= 0.0 && m_time + tau < best.time) {
+                best = { m_time + tau, BALL_CUSHION, index, cushion, m_version[index], 0, 0 };
+            }
+        }
+
+        // Pockets: the ball drops once its centre is inside the pocket radius
+        for (unsigned int p = 0; p < m_pockets->size(); ++p) {
+            const Pocket& pocket = (*m_pockets)[p];
+            distanceQuartic(x - pocket.position.x, y - pocket.position.y, vx, vy, halfAx, halfAy, pocket.radius, coefficients);
+            double tau = firstContact(coefficients, 4, stopTau, true);
+            if (tau >= 0.0 && m_time + tau < best.time) {
+                best = { m_time + tau, BALL_POCKET, index, p, m_version[index], 0, 0 };
+            }
+        }
+    }
+
+    // Other balls: the squared gap between centres is a quartic in time, valid until either ball stops
+    for (unsigned int j = 0; j < balls.size(); ++j) {
+        if (j == index || m_inPocket[j]) {
+            continue;
+        }
+        moveBall(j, m_time);
+
+        double otherVx = balls.vx[j];
+        double otherVy = balls.vy[j];
+        double otherSpeed = std::sqrt(otherVx * otherVx + otherVy * otherVy);
+        if (!moving && otherSpeed == 0.0) {
+            continue;
+        }
+
+        double window = INFINITY;
+        if (moving) window = stopTau;
+        if (otherSpeed > 0.0) window = std::min(window, otherSpeed / m_deceleration);
+
+        // Skip pairs that cannot close the gap within the window
+        double deltaX = balls.x[j] - x;
+        double deltaY = balls.y[j] - y;
+        double contactDistance = radius + balls.radius[j];
+        double gap = std::sqrt(deltaX * deltaX + deltaY * deltaY) - contactDistance;
+        if (gap > (speed + otherSpeed) * window) {
+            continue;
+        }
+
+        double otherHalfAx = otherSpeed > 0.0 ? -0.5 * m_deceleration * otherVx / otherSpeed : 0.0;
+        double otherHalfAy = otherSpeed > 0.0 ? -0.5 * m_deceleration * otherVy / otherSpeed : 0.0;
+        distanceQuartic(deltaX, deltaY, otherVx - vx, otherVy - vy,
+            otherHalfAx - halfAx, otherHalfAy - halfAy, contactDistance, coefficients);
+        if (coefficients[0] <= 0.0 && coefficients[1] > -2.0 * contactDistance * m_restingSpeed) {
+            continue; // Already touching and closing slower than the resting speed: a resting contact, not an impact
+        }
+        double tau = firstContact(coefficients, 4, window, false);
+        if (j == resolvedWith && tau <= kContactEpsilon) {
+            // Rounding can leave a pair that was just resolved still barely closing; queueing it again would repeat
+            // the same contact at the same instant forever
+            continue;
+        }
+        if (tau >= 0.0 && m_time + tau < best.time) {
+            best = { m_time + tau, BALL_BALL, index, j, m_version[index], m_version[j], 0 };
+        }
+    }
+
+    // Each prediction supersedes the ball's last one, even when nothing is queued for it; the id is stamped here
+    // rather than in every candidate above
+    best.id = m_eventSequence++;
+    m_nextEvent[index] = best.id;
+    if (best.time != INFINITY) {
+        m_events.push(best);
+    }
+}
+
+// Check whether every ball an event was predicted against is still on the same trajectory
+bool EventSolver::isValid(const Event& e) const {
+    if (m_version[e.ball] != e.version) {
+        return false;
+    }
+    return e.type != BALL_BALL || m_version[e.other] == e.otherVersion;
+}
+
+// Resolve a ball-ball contact with the same impulse as PhysicsScene::ball2Ball
+double EventSolver::resolveBalls(unsigned int i, unsigned int j) {
+    BallArrays& balls = *m_balls;
+    double deltaX = balls.x[j] - balls.x[i];
+    double deltaY = balls.y[j] - balls.y[i];
+    double distance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+    if (distance == 0.0) {
+        return 0.0;
+    }
+
+    double normalX = deltaX / distance;
+    double normalY = deltaY / distance;
+    double approach = (balls.vx[j] - balls.vx[i]) * normalX + (balls.vy[j] - balls.vy[i]) * normalY;
+    if (approach >= 0.0) {
+        return 0.0; // Already separating
+    }
+
+    // A resting contact absorbs its approach instead of bouncing, so a touching cluster settles rather than collapsing
+    // into ever smaller bounces
+    double restitution = -approach < m_restingSpeed ? 0.0 : kRestitution;
+    double impulse = -(1.0 + restitution) * approach / (balls.invMass[i] + balls.invMass[j]);
+    balls.vx[i] = (float)(balls.vx[i] - impulse * normalX * balls.invMass[i]);
+    balls.vy[i] = (float)(balls.vy[i] - impulse * normalY * balls.invMass[i]);
+    balls.vx[j] = (float)(balls.vx[j] + impulse * normalX * balls.invMass[j]);
+    balls.vy[j] = (float)(balls.vy[j] + impulse * normalY * balls.invMass[j]);
+    return -approach;
+}
+
+// Resolve a ball-cushion contact by reflecting the velocity off the wall
+void EventSolver::resolveCushion(unsigned int index, unsigned int cushion) {
+    BallArrays& balls = *m_balls;
+    float radius = balls.radius[index];
+    switch (cushion) {
+    case 0: balls.x[index] = -m_tableExtents.x + radius; balls.vx[index] = std::fabs(balls.vx[index]); break;
+    case 1: balls.x[index] = m_tableExtents.x - radius; balls.vx[index] = -std::fabs(balls.vx[index]); break;
+    case 2: balls.y[index] = -m_tableExtents.y + radius; balls.vy[index] = std::fabs(balls.vy[index]); break;
+    default: balls.y[index] = m_tableExtents.y - radius; balls.vy[index] = -std::fabs(balls.vy[index]); break;
+    }
+}
+
+// Advance the balls by dt seconds
+void EventSolver::advance(BallArrays& balls, const std::vector<Pocket>& pockets, glm::vec2 tableExtents,
+    float dt, std::vector<unsigned int>& pocketed, std::vector<PhysicsEvent>* events) {
+    m_balls = &balls;
+    m_pockets = &pockets;
+    m_tableExtents = tableExtents;
+    m_eventCount = 0;
+
+    if (!m_valid || m_referenceTime.size() != balls.size()) {
+        rebuild();
+    }
+    else {
+        // Balls changed from outside start a new trajectory from their current array state
+        for (unsigned int index : m_changed) {
+            if (index < balls.size()) {
+                m_referenceTime[index] = m_time;
+                m_version[index]++;
+                m_inPocket[index] = 0;
+                predict(index);
+            }
+        }
+        m_changed.clear();
+    }
+
+    double startTime = m_time;
+    double endTime = m_time + dt;
+    while (!m_events.empty() && m_events.top().time <= endTime) {
+        if (m_eventCount >= kMaxEventsPerAdvance) {
+            // Out of budget: let the balls run to the end of the step without the remaining contacts and predict
+            // afresh next advance, rather than freezing the table
+            m_valid = false;
+            break;
+        }
+
+        Event e = m_events.top();
+        m_events.pop();
+        m_time = std::max(m_time, e.time);
+
+        if (!isValid(e)) {
+            // The event went stale because one participant changed course. A participant still on its old
+            // trajectory only loses its earliest event if this was its latest prediction; otherwise that prediction
+            // is still queued, and predicting again would queue a duplicate.
+            if (m_version[e.ball] == e.version && m_nextEvent[e.ball] == e.id) {
+                predict(e.ball);
+            }
+            if (e.type == BALL_BALL && m_version[e.other] == e.otherVersion && m_nextEvent[e.other] == e.id) {
+                predict(e.other);
+            }
+            continue;
+        }
+
+        m_eventCount++;
+        moveBall(e.ball, m_time);
+        m_version[e.ball]++;
+
+        switch (e.type) {
+        case BALL_BALL: {
+            moveBall(e.other, m_time);
+            m_version[e.other]++;
+            double speed = resolveBalls(e.ball, e.other);
+            if (events && speed > 0.0) {
+                // The balls are exactly touching, so the contact point is one radius along the line between them
+                float deltaX = balls.x[e.other] - balls.x[e.ball];
+                float deltaY = balls.y[e.other] - balls.y[e.ball];
+                float scale = balls.radius[e.ball] / (balls.radius[e.ball] + balls.radius[e.other]);
+                events->push_back({ m_time - startTime, COLLISION_EVENT, e.ball, e.other,
+                    balls.x[e.ball] + deltaX * scale, balls.y[e.ball] + deltaY * scale, (float)speed });
+            }
+            predict(e.ball, e.other);
+            predict(e.other, e.ball);
+            break;
+        }
+        case BALL_CUSHION:
+            if (events) {
+                float speed = std::fabs(e.other < 2 ? balls.vx[e.ball] : balls.vy[e.ball]);
+                float x = e.other == 0 ? -m_tableExtents.x : (e.other == 1 ? m_tableExtents.x : balls.x[e.ball]);
+                float y = e.other == 2 ? -m_tableExtents.y : (e.other == 3 ? m_tableExtents.y : balls.y[e.ball]);
+                events->push_back({ m_time - startTime, CUSHION_EVENT, e.ball, e.other, x, y, speed });
+            }
+            resolveCushion(e.ball, e.other);
+            predict(e.ball);
+            break;
+        case BALL_POCKET:
+            if (events) {
+                float speed = std::sqrt(balls.vx[e.ball] * balls.vx[e.ball] + balls.vy[e.ball] * balls.vy[e.ball]);
+                events->push_back({ m_time - startTime, POCKET_EVENT, e.ball, e.other, balls.x[e.ball], balls.y[e.ball], speed });
+            }
+            balls.vx[e.ball] = 0.0f;
+            balls.vy[e.ball] = 0.0f;
+            m_inPocket[e.ball] = 1;
+            pocketed.push_back(e.ball);
+            break;
+        case BALL_STOP:
+            balls.vx[e.ball] = 0.0f;
+            balls.vy[e.ball] = 0.0f;
+            predict(e.ball);
+            break;
+        }
+    }
+
+    // Bring every ball up to the end of the step so the arrays hold the current state
+    m_time = endTime;
+    for (unsigned int i = 0; i < balls.size(); ++i) {
+        moveBall(i, m_time);
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include "glm/vec2.hpp"
+#include <vector>
+#include <queue>
+#include <functional>
+#include <climits>
+
+struct BallArrays;
+struct Pocket;
+struct PhysicsEvent;
+
+// Event-driven (time-of-impact) solver for the balls of a PhysicsScene.
+// Between impacts a ball decelerates at a constant rate along its direction of travel until it stops,
+// so its position is a quadratic in time and every ball-ball, ball-cushion and ball-pocket contact
+// time can be solved exactly. Contacts are processed in time order from a priority queue, so a whole
+// shot costs one step per event rather than one per fixed timestep, and fast balls cannot tunnel.
+class EventSolver
+{
+public:
+    EventSolver();
+
+    // Discards every prediction; they are rebuilt from the ball arrays on the next advance
+    void reset();
+    // Flags a ball whose state was changed from outside the solver so its predictions are redone
+    void markBallChanged(unsigned int index);
+
+    // Advances the balls by dt seconds, appending the slot of every ball that drops into a pocket to pocketed.
+    // If events is given, every collision, cushion bounce and pocket is appended to it, timed in seconds from the
+    // start of the advance.
+    void advance(BallArrays& balls, const std::vector<Pocket>& pockets, glm::vec2 tableExtents,
+        float dt, std::vector<unsigned int>& pocketed, std::vector<PhysicsEvent>* events = nullptr);
+
+    // Sets the rolling deceleration applied to moving balls (units per second squared)
+    void setDeceleration(float deceleration);
+    // Gets the rolling deceleration applied to moving balls
+    float getDeceleration() const { return m_deceleration; }
+
+    // Sets the closing speed below which a ball-ball contact is resting and absorbs the approach fully instead of bouncing
+    void setRestingSpeed(float speed) { m_restingSpeed = speed; }
+    // Gets the closing speed below which a ball-ball contact is resting
+    float getRestingSpeed() const { return m_restingSpeed; }
+
+    // Gets the number of events processed during the last advance
+    size_t getEventCount() const { return m_eventCount; }
+
+private:
+    enum EventType {
+        BALL_BALL = 0, // Two balls touch
+        BALL_CUSHION,  // A ball touches a cushion (other = 0 left, 1 right, 2 bottom, 3 top)
+        BALL_POCKET,   // A ball's centre enters a pocket (other = pocket index)
+        BALL_STOP      // A ball comes to rest
+    };
+
+    struct Event {
+        double time;          // Absolute simulation time of the event
+        EventType type;       // What happens
+        unsigned int ball;    // Ball the event was predicted for
+        unsigned int other;   // Second ball, cushion or pocket, depending on type
+        unsigned int version; // Version of ball when predicted
+        unsigned int otherVersion; // Version of the second ball when predicted (BALL_BALL only)
+        unsigned int id;      // Sequence number of the prediction, to tell whether it is still ball's latest
+
+        bool operator>(const Event& e) const {
+            if (time != e.time) return time > e.time;
+            if (ball != e.ball) return ball > e.ball;
+            return other > e.other;
+        }
+    };
+
+    // Rebuilds the per-ball bookkeeping and predicts an event for every ball
+    void rebuild();
+    // Moves a ball along its trajectory to time t
+    void moveBall(unsigned int index, double t);
+    // Predicts the earliest event for a ball from the current time and queues it. A contact with resolvedWith that is
+    // due immediately is ignored, since that pair has just been resolved.
+    void predict(unsigned int index, unsigned int resolvedWith = UINT_MAX);
+    // Checks whether every ball an event was predicted against is still on the same trajectory
+    bool isValid(const Event& e) const;
+
+    // Resolves a ball-ball contact, returning the closing speed (0 if the balls were already separating)
+    double resolveBalls(unsigned int i, unsigned int j);
+    // Resolves a ball-cushion contact
+    void resolveCushion(unsigned int index, unsigned int cushion);
+
+    BallArrays* m_balls; // Balls being advanced
+    const std::vector<Pocket>* m_pockets; // Pockets of the table
+    glm::vec2 m_tableExtents; // Half extents of the table
+
+    std::vector<double> m_referenceTime; // Time at which each ball's array state is valid
+    std::vector<unsigned int> m_version; // Bumped whenever a ball's trajectory changes
+    std::vector<unsigned int> m_nextEvent; // Id of each ball's latest prediction
+    std::vector<unsigned char> m_inPocket; // Non-zero once a ball has dropped into a pocket
+    std::vector<unsigned int> m_changed; // Balls changed from outside since the last advance
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> m_events; // Pending events
+
+    double m_time; // Current simulation time
+    unsigned int m_eventSequence; // Id given to the next prediction
+    bool m_valid; // False when the predictions must be rebuilt
+    float m_deceleration; // Rolling deceleration of moving balls
+    float m_restingSpeed; // Closing speed below which a ball-ball contact does not bounce
+    size_t m_eventCount; // Events processed during the last advance
+};
@@ -0,0 +1,104 @@
+#include "MappedFile.h"
+#include <iostream>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+// Constructor for MappedFile
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+}
+
+// Map the file at path
+bool MappedFile::open(const std::string& path) {
+    close();
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        close();
+        return false;
+    }
+    m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = m_mapping ? MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+    m_data = (const unsigned char*)view;
+    m_size = (size_t)size.QuadPart;
+    return true;
+}
+
+// Unmap the file
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    if (m_file != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+// Constructor for MappedFile
+MappedFile::MappedFile() : m_data(nullptr), m_size(0), m_descriptor(-1) {
+}
+
+// Map the file at path
+bool MappedFile::open(const std::string& path) {
+    close();
+    m_descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (m_descriptor < 0 || fstat(m_descriptor, &info) != 0 || info.st_size == 0) {
+        std::cerr << "Failed to open " << path << std::endl;
+        close();
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map " << path << std::endl;
+        close();
+        return false;
+    }
+    m_data = (const unsigned char*)view;
+    m_size = (size_t)info.st_size;
+    return true;
+}
+
+// Unmap the file
+void MappedFile::close() {
+    if (m_data) {
+        munmap((void*)m_data, m_size);
+    }
+    if (m_descriptor >= 0) {
+        ::close(m_descriptor);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_descriptor = -1;
+}
+
+#endif
+
+// Destructor for MappedFile
+MappedFile::~MappedFile() {
+    close();
+}
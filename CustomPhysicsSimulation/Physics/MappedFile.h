@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Pages are read in by the OS as they are touched,
+// so opening a large file costs nothing up front and nothing is copied into the process.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file at path, unmapping any file already open; returns false if it cannot be opened or is empty
+    bool open(const std::string& path);
+    // Unmaps the file
+    void close();
+
+    // Gets the first byte of the file (null when nothing is mapped)
+    const unsigned char* data() const { return m_data; }
+    // Gets the size of the file in bytes
+    size_t size() const { return m_size; }
+
+private:
+    const unsigned char* m_data; // Start of the mapping
+    size_t m_size; // Size of the mapping
+#ifdef _WIN32
+    void* m_file; // File handle
+    void* m_mapping; // File mapping handle
+#else
+    int m_descriptor; // File descriptor
+#endif
+};
@@ -0,0 +1,359 @@
+#include "MultiTableScene.h"
+#include "Sphere.h"
+#include "BallIntegrator.h"
+#include "Simd.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Racks with at least this many balls find their pairs with a uniform grid per table; smaller racks test every
+// slot pair, which is cheaper for them since it covers simd::kWidth tables per comparison
+const unsigned int kGridMinSlots = 1024;
+
+}
+
+// Constructor for MultiTableScene
+MultiTableScene::MultiTableScene(unsigned int tableCount) : m_slotCount(0), m_cueBall(0), m_maxSteps(6000),
+    m_shotsPerSecond(0.0), m_maxRadius(0.0f), m_parkSpacing(0.0f), m_gravity(0, 0), m_timeStep(0.01f),
+    m_tableExtents(100, 50), m_continuousCollision(true), m_sleepSpeed(0.01f) {
+    // Whole registers only, so every load of one ball slot covers tables that belong to this scene
+    m_tableCount = std::max(tableCount, 1u);
+    m_tableCount = (m_tableCount + simd::kWidth - 1) / simd::kWidth * simd::kWidth;
+    m_awakeCount.assign(m_tableCount, 0);
+    m_tableShot.assign(m_tableCount, 0);
+    m_tableBusy.assign(m_tableCount, 0);
+    m_tableDecided.assign(m_tableCount, 0);
+    m_cellSize.assign(m_tableCount, 1.0f);
+}
+
+// Copy the balls, pockets and settings of the scene as the start state of every table
+void MultiTableScene::setTable(const PhysicsScene& scene) {
+    scene.saveSnapshot(m_start);
+    m_slotCount = (unsigned int)m_start.size();
+    m_mass.resize(m_slotCount);
+    m_maxRadius = 0.0f;
+    for (unsigned int s = 0; s < m_slotCount; ++s) {
+        m_mass[s] = scene.getBalls().handles[s]->getMass();
+        m_maxRadius = std::max(m_maxRadius, m_start.radius[s]);
+    }
+    m_parkSpacing = m_maxRadius * 4.0f;
+
+    m_gravity = scene.getGravity();
+    m_timeStep = scene.getTimeStep();
+    m_tableExtents = scene.getTableExtents();
+    m_pockets = scene.getPockets();
+    m_continuousCollision = scene.getContinuousCollision();
+    m_sleepSpeed = scene.getSleepSpeed();
+
+    size_t count = (size_t)m_slotCount * m_tableCount;
+    m_balls.x.assign(count, 0.0f);
+    m_balls.y.assign(count, 0.0f);
+    m_balls.vx.assign(count, 0.0f);
+    m_balls.vy.assign(count, 0.0f);
+    m_balls.invMass.assign(count, 0.0f);
+    m_balls.radius.assign(count, 0.0f);
+    m_balls.previousX.assign(count, 0.0f);
+    m_balls.previousY.assign(count, 0.0f);
+    m_balls.sleeping.assign(count, 1);
+    m_balls.handles.clear();
+    if (m_slotCount < kGridMinSlots) {
+        m_cellX.resize(count);
+        m_cellY.resize(count);
+    }
+    else {
+        m_tableX.resize(m_slotCount);
+        m_tableY.resize(m_slotCount);
+        m_tableSleeping.resize(m_slotCount);
+    }
+    m_awakeCount.assign(m_tableCount, 0);
+    m_tableBusy.assign(m_tableCount, 0);
+}
+
+// Load the next shot in the queue onto a table, or put the table to sleep if the queue is empty
+bool MultiTableScene::startNextShot(unsigned int table, const std::vector<Shot>& shots, size_t& nextShot,
+    std::vector<ShotOutcome>& outcomes) {
+    while (nextShot < shots.size()) {
+        size_t k = nextShot++;
+        ShotOutcome& outcome = outcomes[k];
+        outcome.pocketedBalls.clear();
+        outcome.scratch = false;
+        outcome.stepCount = 0;
+        outcome.stoppedEarly = false;
+
+        // Copy the start state into this table's lane of every array
+        for (unsigned int s = 0; s < m_slotCount; ++s) {
+            size_t e = entry(s, table);
+            m_balls.x[e] = m_start.x[s];
+            m_balls.y[e] = m_start.y[s];
+            m_balls.vx[e] = m_start.vx[s];
+            m_balls.vy[e] = m_start.vy[s];
+            m_balls.invMass[e] = m_start.invMass[s];
+            m_balls.radius[e] = m_start.radius[s];
+            m_balls.previousX[e] = m_start.previousX[s];
+            m_balls.previousY[e] = m_start.previousY[s];
+            m_balls.sleeping[e] = m_start.sleeping[s];
+        }
+        m_awakeCount[table] = m_start.awakeCount;
+
+        // Strike the cue ball with the same operations as Sphere::applyForce
+        size_t cue = entry(m_cueBall, table);
+        glm::vec2 force = glm::vec2(std::cos(shots[k].angle), std::sin(shots[k].angle)) * shots[k].force;
+        glm::vec2 velocity = glm::vec2(m_balls.vx[cue], m_balls.vy[cue]) + force / m_mass[m_cueBall];
+        m_balls.vx[cue] = velocity.x;
+        m_balls.vy[cue] = velocity.y;
+        if (m_balls.sleeping[cue]) {
+            m_balls.sleeping[cue] = 0;
+            m_awakeCount[table]++;
+        }
+
+        if (outcome.stepCount < m_maxSteps) {
+            m_tableShot[table] = k;
+            m_tableBusy[table] = 1;
+            return true;
+        }
+        outcome.cueBallPosition = glm::vec2(m_balls.x[cue], m_balls.y[cue]);
+    }
+
+    // Nothing left to play: put the whole table to sleep so every pass skips it
+    for (unsigned int s = 0; s < m_slotCount; ++s) {
+        m_balls.sleeping[entry(s, table)] = 1;
+    }
+    m_awakeCount[table] = 0;
+    m_tableBusy[table] = 0;
+    return false;
+}
+
+// Play every shot, refilling each table from the queue as its shot comes to rest
+void MultiTableScene::evaluate(const std::vector<Shot>& shots, std::vector<ShotOutcome>& outcomes) {
+    outcomes.resize(shots.size());
+    auto start = std::chrono::steady_clock::now();
+
+    if (m_cueBall >= m_slotCount) {
+        for (ShotOutcome& outcome : outcomes) {
+            outcome.pocketedBalls.clear();
+            outcome.cueBallPosition = glm::vec2(0);
+            outcome.scratch = false;
+            outcome.stepCount = 0;
+            outcome.stoppedEarly = false;
+        }
+        m_shotsPerSecond = 0.0;
+        return;
+    }
+
+    size_t nextShot = 0;
+    unsigned int busyTables = 0;
+    for (unsigned int t = 0; t < m_tableCount; ++t) {
+        busyTables += startNextShot(t, shots, nextShot, outcomes);
+    }
+
+    while (busyTables > 0) {
+        step();
+
+        // Record and park pocketed balls after the step, as ShotEvaluator does
+        for (size_t e : m_pocketed) {
+            unsigned int slot = (unsigned int)(e / m_tableCount);
+            unsigned int table = (unsigned int)(e % m_tableCount);
+            ShotOutcome& outcome = outcomes[m_tableShot[table]];
+            if (slot == m_cueBall) {
+                outcome.scratch = true;
+                outcome.cueBallPosition = glm::vec2(m_balls.x[e], m_balls.y[e]);
+                m_tableDecided[table] |= m_stop.cueBallPocketed;
+            }
+            else {
+                outcome.pocketedBalls.push_back(slot);
+                m_tableDecided[table] |= (int)slot == m_stop.targetBall;
+            }
+            parkBall(slot, table);
+        }
+
+        for (unsigned int t = 0; t < m_tableCount; ++t) {
+            if (!m_tableBusy[t]) continue;
+            ShotOutcome& outcome = outcomes[m_tableShot[t]];
+            outcome.stepCount++;
+            bool decided = m_tableDecided[t] || m_stop.isQuiet(m_balls, entry(0, t), m_tableCount, m_slotCount, m_pockets);
+            m_tableDecided[t] = 0;
+            if (decided) {
+                outcome.stoppedEarly = m_awakeCount[t] > 0;
+            }
+            else if (m_awakeCount[t] > 0 && outcome.stepCount < m_maxSteps) {
+                continue;
+            }
+
+            // This table is done: finish its outcome and hand the lane the next shot
+            if (!outcome.scratch) {
+                size_t cue = entry(m_cueBall, t);
+                outcome.cueBallPosition = glm::vec2(m_balls.x[cue], m_balls.y[cue]);
+            }
+            if (!startNextShot(t, shots, nextShot, outcomes)) {
+                busyTables--;
+            }
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_shotsPerSecond = seconds > 0.0 ? shots.size() / seconds : 0.0;
+}
+
+// Advance every table by one fixed step, mirroring PhysicsScene::simulate
+void MultiTableScene::step() {
+    const float dt = m_timeStep;
+    BallIntegrator::integrate(m_balls, m_gravity, dt);
+
+    findPairs();
+    if (!m_pairs.empty()) {
+        m_pairKernel.schedule(m_pairs, m_balls.size());
+        m_pairKernel.collide(m_balls, m_pairs, dt, m_continuousCollision, m_pairTouched);
+        for (size_t k = 0; k < m_pairs.size(); ++k) {
+            if (!m_pairTouched[k]) continue;
+            for (unsigned int e : { m_pairs[k].a, m_pairs[k].b }) {
+                if (m_balls.sleeping[e]) {
+                    m_balls.sleeping[e] = 0;
+                    m_awakeCount[e % m_tableCount]++;
+                }
+            }
+        }
+    }
+
+    BallIntegrator::dampAndBounce(m_balls, m_tableExtents, 0.99f, m_continuousCollision);
+
+    // Pockets, with the same closest-point-on-path test as PhysicsScene::detectPockets
+    m_pocketed.clear();
+    for (size_t e = 0; e < m_balls.size(); ++e) {
+        if (m_balls.sleeping[e]) continue;
+        for (const Pocket& pocket : m_pockets) {
+            float deltaX = m_balls.x[e] - pocket.position.x;
+            float deltaY = m_balls.y[e] - pocket.position.y;
+            if (m_continuousCollision) {
+                float pathX = m_balls.x[e] - m_balls.previousX[e];
+                float pathY = m_balls.y[e] - m_balls.previousY[e];
+                float pathLengthSquared = pathX * pathX + pathY * pathY;
+                if (pathLengthSquared > 0.0f) {
+                    float t = std::min(std::max((deltaX * pathX + deltaY * pathY) / pathLengthSquared, 0.0f), 1.0f);
+                    deltaX -= pathX * t;
+                    deltaY -= pathY * t;
+                }
+            }
+            if (std::sqrt(deltaX * deltaX + deltaY * deltaY) < pocket.radius) {
+                m_pocketed.push_back(e);
+                break;
+            }
+        }
+    }
+
+    // Sleep, as PhysicsScene::updateSleepState (nothing sleeps under gravity)
+    if (m_gravity != glm::vec2(0, 0)) {
+        return;
+    }
+    for (size_t e = 0; e < m_balls.size(); ++e) {
+        if (m_balls.sleeping[e]) continue;
+        float speed = std::sqrt(m_balls.vx[e] * m_balls.vx[e] + m_balls.vy[e] * m_balls.vy[e]);
+        if (speed <= m_sleepSpeed) {
+            m_balls.vx[e] = 0.0f;
+            m_balls.vy[e] = 0.0f;
+            m_balls.sleeping[e] = 1;
+            m_awakeCount[e % m_tableCount]--;
+        }
+    }
+}
+
+// Collect the candidate pairs of every table, as each table's uniform grid would find them
+void MultiTableScene::findPairs() {
+    const float dt = m_timeStep;
+    const unsigned int T = m_tableCount;
+    size_t count = m_balls.size();
+
+    // Each table sizes its cells from its own longest path this step, exactly as PhysicsScene::collideSpheres does
+    for (unsigned int t = 0; t < T; ++t) {
+        float cellSize = m_maxRadius * 2.0f;
+        if (m_continuousCollision) {
+            float maxTravel = 0.0f;
+            for (unsigned int s = 0; s < m_slotCount; ++s) {
+                size_t e = entry(s, t);
+                maxTravel = std::max(maxTravel, std::sqrt(m_balls.vx[e] * m_balls.vx[e] + m_balls.vy[e] * m_balls.vy[e]) * dt);
+            }
+            cellSize = m_maxRadius * 2.0f + maxTravel;
+        }
+        m_cellSize[t] = cellSize > 0.0f ? cellSize : 1.0f;
+    }
+    m_pairs.clear();
+
+    // Large racks: build each table's grid from its own balls, exactly as PhysicsScene does, so finding the pairs
+    // costs O(slots) per table rather than O(slots^2)
+    if (m_slotCount >= kGridMinSlots) {
+        for (unsigned int t = 0; t < T; ++t) {
+            // A table with every ball asleep has no candidates
+            if (m_awakeCount[t] == 0) continue;
+            for (unsigned int s = 0; s < m_slotCount; ++s) {
+                size_t e = entry(s, t);
+                m_tableX[s] = m_balls.x[e];
+                m_tableY[s] = m_balls.y[e];
+                if (m_continuousCollision) {
+                    m_tableX[s] = m_balls.x[e] - m_balls.vx[e] * dt * 0.5f;
+                    m_tableY[s] = m_balls.y[e] - m_balls.vy[e] * dt * 0.5f;
+                }
+                m_tableSleeping[s] = m_balls.sleeping[e];
+            }
+            m_grid.build(m_tableX.data(), m_tableY.data(), m_slotCount, m_cellSize[t]);
+            m_tablePairs.clear();
+            m_grid.findPairs(m_tablePairs, m_tableSleeping.data());
+            for (const CandidatePair& pair : m_tablePairs) {
+                m_pairs.push_back({ (unsigned int)entry(pair.a, t), (unsigned int)entry(pair.b, t) });
+            }
+        }
+        return;
+    }
+
+    for (size_t e = 0; e < count; ++e) {
+        float x = m_balls.x[e];
+        float y = m_balls.y[e];
+        if (m_continuousCollision) {
+            x = m_balls.x[e] - m_balls.vx[e] * dt * 0.5f;
+            y = m_balls.y[e] - m_balls.vy[e] * dt * 0.5f;
+        }
+        float invCellSize = 1.0f / m_cellSize[e % T];
+        m_cellX[e] = std::floor(x * invCellSize);
+        m_cellY[e] = std::floor(y * invCellSize);
+    }
+
+    // Small racks: two balls are candidates when their cells are neighbours and at least one is awake. Pairs are
+    // emitted slot pair by slot pair, so each table's pairs keep the brute-force order, and the same pair on every
+    // table sits side by side.
+    const simd::Float one = simd::broadcast(1.0f);
+    const simd::Float minusOne = simd::broadcast(-1.0f);
+    for (unsigned int i = 0; i < m_slotCount; ++i) {
+        for (unsigned int j = i + 1; j < m_slotCount; ++j) {
+            for (unsigned int t = 0; t < T; t += simd::kWidth) {
+                size_t ei = entry(i, t);
+                size_t ej = entry(j, t);
+                simd::Float cellDeltaX = simd::load(&m_cellX[ej]) - simd::load(&m_cellX[ei]);
+                simd::Float cellDeltaY = simd::load(&m_cellY[ej]) - simd::load(&m_cellY[ei]);
+                simd::Mask neighbours = (cellDeltaX <= one) & (cellDeltaX >= minusOne) & (cellDeltaY <= one) & (cellDeltaY >= minusOne);
+                simd::Mask bothSleeping = simd::loadFlags(&m_balls.sleeping[ei]) & simd::loadFlags(&m_balls.sleeping[ej]);
+                int bits = simd::bits(neighbours & ~bothSleeping);
+                for (int lane = 0; bits != 0; ++lane, bits >>= 1) {
+                    if (bits & 1) {
+                        m_pairs.push_back({ (unsigned int)(ei + lane), (unsigned int)(ej + lane) });
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Move a pocketed ball off its table and put it to sleep
+void MultiTableScene::parkBall(unsigned int slot, unsigned int table) {
+    size_t e = entry(slot, table);
+    glm::vec2 position(m_tableExtents.x * 2.0f + m_parkSpacing, slot * m_parkSpacing);
+    m_balls.x[e] = position.x;
+    m_balls.y[e] = position.y;
+    m_balls.previousX[e] = position.x;
+    m_balls.previousY[e] = position.y;
+    m_balls.vx[e] = 0.0f;
+    m_balls.vy[e] = 0.0f;
+    if (!m_balls.sleeping[e]) {
+        m_balls.sleeping[e] = 1;
+        m_awakeCount[table]--;
+    }
+}
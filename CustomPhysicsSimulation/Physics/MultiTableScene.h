@@ -0,0 +1,100 @@
+#pragma once
+#include "glm/vec2.hpp"
+#include "PhysicsScene.h"
+#include "ShotEvaluator.h"
+#include <vector>
+
+// Plays many shots from the same table in lockstep, one independent copy of the table per SIMD lane.
+// The ball arrays are interleaved by table (AoSoA): ball slot s of table t is entry s * tableCount + t, so one
+// register of any array holds the same ball across simd::kWidth tables and the SIMD integrate, friction/cushion
+// and narrowphase passes advance all of them at once. A table whose balls have all come to rest is sleeping,
+// so it is masked out of every pass until its lane is refilled with the next shot from the queue.
+// Each table runs the same fixed step as PhysicsScene (uniform grid, sleeping, pockets), so every outcome is
+// bit-identical to ShotEvaluator playing the same shot. Planes and the event-driven solver are not supported.
+class MultiTableScene
+{
+public:
+    // Creates room for tableCount tables, rounded up to a whole number of SIMD registers; 0 gives one register's worth
+    explicit MultiTableScene(unsigned int tableCount = 0);
+
+    // Copies the balls, pockets and settings of the scene as the start state of every table
+    void setTable(const PhysicsScene& scene);
+
+    // Sets the slot of the cue ball in the table (defaults to 0, as in the app)
+    void setCueBall(unsigned int index) { m_cueBall = index; }
+    // Gets the slot of the cue ball in the table
+    unsigned int getCueBall() const { return m_cueBall; }
+
+    // Sets the most fixed steps a shot may run before it is cut off
+    void setMaxSteps(int maxSteps) { m_maxSteps = maxSteps; }
+    // Gets the most fixed steps a shot may run
+    int getMaxSteps() const { return m_maxSteps; }
+
+    // Sets the conditions that end a shot before every ball has stopped
+    void setStopConditions(const RolloutStop& stop) { m_stop = stop; }
+    // Gets the conditions that end a shot before every ball has stopped
+    const RolloutStop& getStopConditions() const { return m_stop; }
+
+    // Plays every shot and writes outcomes[k] for shots[k]. Shots are taken from the queue in order,
+    // one per free table, and a table is refilled as soon as its shot comes to rest.
+    void evaluate(const std::vector<Shot>& shots, std::vector<ShotOutcome>& outcomes);
+
+    // Gets the number of tables simulated side by side
+    unsigned int getTableCount() const { return m_tableCount; }
+    // Gets the throughput of the last batch, in shots per second of wall-clock time
+    double getShotsPerSecond() const { return m_shotsPerSecond; }
+
+private:
+    // Gets the entry of a ball slot of a table in the interleaved arrays
+    size_t entry(unsigned int slot, unsigned int table) const { return (size_t)slot * m_tableCount + table; }
+
+    // Loads the next shot in the queue onto a table, or puts the table to sleep if the queue is empty
+    // (nextShot is the head of the queue). Returns whether the table is now playing a shot.
+    bool startNextShot(unsigned int table, const std::vector<Shot>& shots, size_t& nextShot, std::vector<ShotOutcome>& outcomes);
+    // Advances every table by one fixed step, filling m_pocketed with the entries that dropped into a pocket
+    void step();
+    // Collects the candidate pairs of every table, as each table's uniform grid would find them. Racks of fewer than
+    // 1024 balls compare every slot pair across simd::kWidth tables at once (O(slots^2 * tables / kWidth)), which
+    // beats a grid per table at those sizes; larger racks build a grid per table instead (O(slots * tables)).
+    void findPairs();
+    // Moves a pocketed ball off its table and puts it to sleep, as ShotEvaluator does
+    void parkBall(unsigned int slot, unsigned int table);
+
+    unsigned int m_tableCount; // Number of tables (a multiple of simd::kWidth)
+    unsigned int m_slotCount; // Balls per table
+    unsigned int m_cueBall; // Slot of the cue ball
+    int m_maxSteps; // Most fixed steps a shot may run
+    RolloutStop m_stop; // Conditions that end a shot early
+    double m_shotsPerSecond; // Throughput of the last batch
+
+    // Start state and settings, copied from the source scene
+    SceneSnapshot m_start; // Ball state every shot starts from (one table, not interleaved)
+    std::vector<float> m_mass; // Mass of each ball slot, used to turn a shot's force into velocity
+    float m_maxRadius; // Largest ball radius, which sizes the grid cells
+    float m_parkSpacing; // Distance between parked balls
+    glm::vec2 m_gravity; // Gravity of the source scene
+    float m_timeStep; // Fixed step of the source scene
+    glm::vec2 m_tableExtents; // Half extents of the table
+    std::vector<Pocket> m_pockets; // Pockets of the table
+    bool m_continuousCollision; // Whether balls are swept against each other, cushions and pockets
+    float m_sleepSpeed; // Speed below which a ball falls asleep
+
+    // Lockstep state
+    BallArrays m_balls; // Every table's balls, interleaved by table (no handles)
+    std::vector<size_t> m_awakeCount; // Number of awake balls on each table
+    std::vector<size_t> m_tableShot; // Shot each table is playing (ignored while the table is idle)
+    std::vector<unsigned char> m_tableBusy; // Whether each table is playing a shot
+    std::vector<unsigned char> m_tableDecided; // Whether a stop condition was met on each table this step
+    std::vector<float> m_cellSize; // Grid cell size of each table for this step
+    std::vector<float> m_cellX; // Grid cell x of each entry for this step (small racks)
+    std::vector<float> m_cellY; // Grid cell y of each entry for this step (small racks)
+    SpatialGrid m_grid; // Uniform grid rebuilt for one table at a time (large racks)
+    std::vector<float> m_tableX; // Grid position of each slot of the table being gridded
+    std::vector<float> m_tableY;
+    std::vector<unsigned char> m_tableSleeping; // Sleeping flag of each slot of the table being gridded
+    std::vector<CandidatePair> m_tablePairs; // Candidate pairs of the table being gridded, by slot
+    std::vector<CandidatePair> m_pairs; // Candidate pairs of every table for this step
+    BallPairKernel m_pairKernel; // SIMD narrowphase shared by every table
+    std::vector<unsigned char> m_pairTouched; // Whether each candidate pair made contact
+    std::vector<size_t> m_pocketed; // Entries that dropped into a pocket this step
+};
@@ -0,0 +1,889 @@
+#include "PhysicsScene.h"
+#include "ReplayWriter.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "ThreadPool.h"
+#include <iostream> 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/detail/func_geometric.hpp>
+
+// Initialise the collision function array, indexed by [shape1 * SHAPE_COUNT + shape2].
+// Boxes have no collision routines yet, so their entries are left empty.
+PhysicsScene::fn PhysicsScene::collisionFunctionArray[SHAPE_COUNT * SHAPE_COUNT] =
+{
+    PhysicsScene::plane2Plane,  PhysicsScene::plane2Sphere,  nullptr,
+    PhysicsScene::sphere2Plane, PhysicsScene::sphere2Sphere, nullptr,
+    nullptr,                    nullptr,                     nullptr
+};
+
+// Constructor for PhysicsScene
+PhysicsScene::PhysicsScene() : m_gravity(glm::vec2(0, 0)), m_timeStep(0.01f),
+    m_accumulator(0.0f), m_interpolation(1.0f), m_maxSubsteps(8), m_substepCount(0), m_time(0.0),
+    m_solver(FIXED_STEP), m_tableExtents(100, 50),
+    m_continuousCollision(true), m_broadphase(UNIFORM_GRID),
+    m_narrowphase(SIMD_NARROWPHASE), m_integrator(SIMD_INTEGRATOR), m_dispatch(SHAPE_TYPE_DISPATCH), m_candidatePairCount(0),
+    m_awakeCount(0), m_sleepSpeed(0.01f), m_replayWriter(nullptr), m_replayClock(0.0f), m_eventLog(nullptr),
+    m_keepEvents(false) {
+}
+
+// Destructor for PhysicsScene
+PhysicsScene::~PhysicsScene() {
+    // Detach the sphere handles first so deleting them never touches the ball arrays
+    for (Sphere* sphere : m_balls.handles) {
+        sphere->m_scene = nullptr;
+    }
+    for (auto pActor : m_actors) {
+        delete pActor;
+    }
+}
+
+// Add an actor to the physics scene
+void PhysicsScene::addActor(PhysicsObject* actor) {
+    if (actor) {
+        m_actors.push_back(actor);
+        if (actor->getShapeID() == SPHERE) {
+            addBall(static_cast<Sphere*>(actor));
+        }
+        else {
+            m_otherActors.push_back(actor);
+        }
+    }
+    else {
+        std::cerr << "Attempted to add a nullptr actor." << std::endl;
+    }
+}
+
+// Remove an actor from the physics scene
+void PhysicsScene::removeActor(PhysicsObject* actor) {
+    auto it = std::remove(m_actors.begin(), m_actors.end(), actor);
+    if (it != m_actors.end()) {
+        m_actors.erase(it);
+        if (actor->getShapeID() == SPHERE) {
+            removeBall(static_cast<Sphere*>(actor)->m_ballIndex);
+        }
+        else {
+            m_otherActors.erase(std::remove(m_otherActors.begin(), m_otherActors.end(), actor), m_otherActors.end());
+        }
+    }
+    else {
+        std::cerr << "Attempted to remove an actor that was not found: " << actor << std::endl;
+    }
+}
+
+// Copy a sphere's state into a new ball slot and point the sphere at it
+void PhysicsScene::addBall(Sphere* sphere) {
+    glm::vec2 position = sphere->getPosition();
+    glm::vec2 velocity = sphere->getVelocity();
+
+    m_balls.x.push_back(position.x);
+    m_balls.y.push_back(position.y);
+    m_balls.vx.push_back(velocity.x);
+    m_balls.vy.push_back(velocity.y);
+    m_balls.invMass.push_back(1.0f / sphere->getMass());
+    m_balls.radius.push_back(sphere->getRadius());
+    m_balls.previousX.push_back(position.x);
+    m_balls.previousY.push_back(position.y);
+    m_balls.sleeping.push_back(0);
+    m_balls.handles.push_back(sphere);
+    m_awakeCount++;
+
+    sphere->m_scene = this;
+    sphere->m_ballIndex = (unsigned int)(m_balls.size() - 1);
+    m_eventSolver.reset();
+}
+
+// Copy a ball's state back into its sphere and remove the slot.
+// Later slots shift down by one so ball order (and therefore contact order) is preserved.
+void PhysicsScene::removeBall(unsigned int index) {
+    Sphere* sphere = m_balls.handles[index];
+    glm::vec2 position = sphere->getPosition();
+    glm::vec2 velocity = sphere->getVelocity();
+    sphere->m_scene = nullptr;
+    sphere->m_position = position;
+    sphere->m_velocity = velocity;
+    if (!m_balls.sleeping[index]) {
+        m_awakeCount--;
+    }
+
+    m_balls.x.erase(m_balls.x.begin() + index);
+    m_balls.y.erase(m_balls.y.begin() + index);
+    m_balls.vx.erase(m_balls.vx.begin() + index);
+    m_balls.vy.erase(m_balls.vy.begin() + index);
+    m_balls.invMass.erase(m_balls.invMass.begin() + index);
+    m_balls.radius.erase(m_balls.radius.begin() + index);
+    m_balls.previousX.erase(m_balls.previousX.begin() + index);
+    m_balls.previousY.erase(m_balls.previousY.begin() + index);
+    m_balls.sleeping.erase(m_balls.sleeping.begin() + index);
+    m_balls.handles.erase(m_balls.handles.begin() + index);
+
+    for (size_t i = index; i < m_balls.size(); ++i) {
+        m_balls.handles[i]->m_ballIndex = (unsigned int)i;
+    }
+    m_eventSolver.reset();
+}
+
+// Set the engine used to advance the balls
+void PhysicsScene::setSolver(SolverType solver) {
+    m_solver = solver;
+    m_eventSolver.reset();
+}
+
+// Set the gravity for the physics scene
+void PhysicsScene::setGravity(const glm::vec2 gravity) {
+    m_gravity = gravity;
+    // A slow ball under gravity is not at rest, so nothing may stay asleep
+    if (m_gravity != glm::vec2(0, 0)) {
+        for (unsigned int i = 0; i < m_balls.size(); ++i) {
+            wakeBall(i);
+        }
+    }
+}
+
+// Wake a sleeping ball
+void PhysicsScene::wakeBall(unsigned int index) {
+    if (m_balls.sleeping[index]) {
+        m_balls.sleeping[index] = 0;
+        m_awakeCount++;
+    }
+}
+
+// Set how many threads resolve ball contacts
+void PhysicsScene::setWorkerCount(unsigned int workerCount) {
+    if (workerCount <= 1) {
+        m_threadPool.reset();
+    }
+    else if (workerCount != getWorkerCount()) {
+        m_threadPool.reset(new ThreadPool(workerCount));
+    }
+}
+
+// Get how many threads resolve ball contacts
+unsigned int PhysicsScene::getWorkerCount() const {
+    return m_threadPool ? m_threadPool->getThreadCount() : 1;
+}
+
+// Notify the scene that a ball's state was changed from outside the solver
+void PhysicsScene::markBallChanged(unsigned int index) {
+    wakeBall(index);
+    if (m_solver == EVENT_DRIVEN) {
+        m_eventSolver.markBallChanged(index);
+    }
+}
+
+namespace {
+
+    // Copies one ball array into another of the same type, reusing the destination's storage
+    template <typename T>
+    void copyArray(std::vector<T>& destination, const std::vector<T>& source) {
+        destination.resize(source.size());
+        if (!source.empty()) {
+            std::memcpy(destination.data(), source.data(), source.size() * sizeof(T));
+        }
+    }
+}
+
+// Copy the state of every ball, and the clocks, into a snapshot
+void PhysicsScene::saveSnapshot(SceneSnapshot& snapshot) const {
+    copyArray(snapshot.x, m_balls.x);
+    copyArray(snapshot.y, m_balls.y);
+    copyArray(snapshot.vx, m_balls.vx);
+    copyArray(snapshot.vy, m_balls.vy);
+    copyArray(snapshot.invMass, m_balls.invMass);
+    copyArray(snapshot.radius, m_balls.radius);
+    copyArray(snapshot.previousX, m_balls.previousX);
+    copyArray(snapshot.previousY, m_balls.previousY);
+    copyArray(snapshot.sleeping, m_balls.sleeping);
+    snapshot.awakeCount = m_awakeCount;
+    snapshot.accumulator = m_accumulator;
+    snapshot.interpolation = m_interpolation;
+    snapshot.substepCount = m_substepCount;
+    snapshot.time = m_time;
+}
+
+// Put every ball back to the state in a snapshot
+bool PhysicsScene::restoreSnapshot(const SceneSnapshot& snapshot) {
+    if (snapshot.size() != m_balls.size()) {
+        std::cerr << "Snapshot holds " << snapshot.size() << " balls but the scene holds " << m_balls.size() << std::endl;
+        return false;
+    }
+
+    // The sizes match, so these are plain copies into the existing arrays
+    copyArray(m_balls.x, snapshot.x);
+    copyArray(m_balls.y, snapshot.y);
+    copyArray(m_balls.vx, snapshot.vx);
+    copyArray(m_balls.vy, snapshot.vy);
+    copyArray(m_balls.invMass, snapshot.invMass);
+    copyArray(m_balls.radius, snapshot.radius);
+    copyArray(m_balls.previousX, snapshot.previousX);
+    copyArray(m_balls.previousY, snapshot.previousY);
+    copyArray(m_balls.sleeping, snapshot.sleeping);
+    m_awakeCount = snapshot.awakeCount;
+    m_accumulator = snapshot.accumulator;
+    m_interpolation = snapshot.interpolation;
+    m_substepCount = snapshot.substepCount;
+    m_time = snapshot.time;
+
+    m_pocketedBalls.clear();
+    m_events.clear();
+    m_eventSolver.reset();
+    return true;
+}
+
+// Put a ball to sleep straight away
+void PhysicsScene::sleepBall(unsigned int index) {
+    m_balls.vx[index] = 0.0f;
+    m_balls.vy[index] = 0.0f;
+    if (!m_balls.sleeping[index]) {
+        m_balls.sleeping[index] = 1;
+        m_awakeCount--;
+    }
+    if (m_solver == EVENT_DRIVEN) {
+        m_eventSolver.markBallChanged(index);
+    }
+}
+
+// Collision detection between two planes (always returns false as planes do not collide)
+bool PhysicsScene::plane2Plane(PhysicsObject* obj1, PhysicsObject* obj2) {
+    return false; // Planes do not collide with each other
+}
+
+// Collision detection between a plane and a sphere
+bool PhysicsScene::plane2Sphere(PhysicsObject* obj1, PhysicsObject* obj2) {
+    return sphere2Plane(obj2, obj1);
+}
+
+// Collision detection between a sphere and a plane
+bool PhysicsScene::sphere2Plane(PhysicsObject* obj1, PhysicsObject* obj2) {
+    if (obj1->getShapeID() == SPHERE && obj2->getShapeID() == PLANE) {
+        Sphere* sphere = static_cast<Sphere*>(obj1);
+        Plane* plane = static_cast<Plane*>(obj2);
+
+        float distance = glm::dot(sphere->getPosition(), plane->getNormal()) - plane->getDistance();
+        if (distance < sphere->getRadius()) {
+            sphere->setVelocity(glm::vec2(0)); // Stop the sphere
+            return true; // Collision detected
+        }
+    }
+    return false; // No collision
+}
+
+// Collision detection between two spheres
+bool PhysicsScene::sphere2Sphere(PhysicsObject* obj1, PhysicsObject* obj2) {
+    if (obj1->getShapeID() == SPHERE && obj2->getShapeID() == SPHERE) {
+        Sphere* sphere1 = static_cast<Sphere*>(obj1);
+        Sphere* sphere2 = static_cast<Sphere*>(obj2);
+
+        // Spheres in the same scene are resolved directly on the ball arrays
+        if (sphere1->m_scene && sphere1->m_scene == sphere2->m_scene) {
+            return ball2Ball(sphere1->m_scene->m_balls, sphere1->m_ballIndex, sphere2->m_ballIndex);
+        }
+
+        glm::vec2 pos1 = sphere1->getPosition();
+        glm::vec2 pos2 = sphere2->getPosition();
+        float radius1 = sphere1->getRadius();
+        float radius2 = sphere2->getRadius();
+
+        glm::vec2 delta = pos2 - pos1;
+        float distance = glm::length(delta);
+        float intersection = radius1 + radius2 - distance;
+
+        if (intersection > 0) {
+            glm::vec2 collisionNormal = glm::normalize(delta);
+            glm::vec2 relativeVelocity = sphere2->getVelocity() - sphere1->getVelocity();
+
+            // Coefficient of restitution (controls elasticity)
+            float restitution = 0.8f; // Adjust for more realistic bounces
+
+            // Compute the impulse scalar
+            float impulseMagnitude = (-(1.0f + restitution) * glm::dot(relativeVelocity, collisionNormal)) /
+                ((1.0f / sphere1->getMass()) + (1.0f / sphere2->getMass()));
+
+            glm::vec2 impulse = impulseMagnitude * collisionNormal;
+
+            // Apply the impulse to both spheres
+            sphere1->applyForce(-impulse);
+            sphere2->applyForce(impulse);
+
+            // Separate the spheres to prevent sticking
+            glm::vec2 separation = collisionNormal * intersection * 0.5f;
+            sphere1->setPosition(pos1 - separation);
+            sphere2->setPosition(pos2 + separation);
+
+            return true;
+        }
+    }
+    return false;
+}
+
+// Collision detection and response between two balls stored in the same arrays
+bool PhysicsScene::ball2Ball(BallArrays& balls, unsigned int i, unsigned int j) {
+    float deltaX = balls.x[j] - balls.x[i];
+    float deltaY = balls.y[j] - balls.y[i];
+    float distance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+    float intersection = balls.radius[i] + balls.radius[j] - distance;
+
+    if (intersection > 0) {
+        float normalX = deltaX / distance;
+        float normalY = deltaY / distance;
+        float relativeVelocityX = balls.vx[j] - balls.vx[i];
+        float relativeVelocityY = balls.vy[j] - balls.vy[i];
+
+        // Coefficient of restitution (controls elasticity)
+        float restitution = 0.8f;
+
+        // Compute the impulse scalar and apply it to both balls
+        float impulseMagnitude = (-(1.0f + restitution) * (relativeVelocityX * normalX + relativeVelocityY * normalY)) /
+            (balls.invMass[i] + balls.invMass[j]);
+        float impulseX = impulseMagnitude * normalX;
+        float impulseY = impulseMagnitude * normalY;
+        balls.vx[i] -= impulseX * balls.invMass[i];
+        balls.vy[i] -= impulseY * balls.invMass[i];
+        balls.vx[j] += impulseX * balls.invMass[j];
+        balls.vy[j] += impulseY * balls.invMass[j];
+
+        // Separate the balls to prevent sticking
+        float separationX = normalX * intersection * 0.5f;
+        float separationY = normalY * intersection * 0.5f;
+        balls.x[i] -= separationX;
+        balls.y[i] -= separationY;
+        balls.x[j] += separationX;
+        balls.y[j] += separationY;
+
+        return true;
+    }
+    return false;
+}
+
+// Run only the integrate and friction/cushion passes of a fixed step
+void PhysicsScene::stepIntegrator(float dt) {
+    runIntegrator(dt);
+    runFrictionAndWalls();
+}
+
+// Save every ball's previous position and advance its velocity and position with the selected integrator
+void PhysicsScene::runIntegrator(float dt) {
+    if (m_integrator == SIMD_INTEGRATOR) {
+        BallIntegrator::integrate(m_balls, m_gravity, dt);
+    }
+    else {
+        m_balls.previousX = m_balls.x;
+        m_balls.previousY = m_balls.y;
+        integrateBalls(dt);
+    }
+}
+
+// Apply friction and bounce balls off the table boundary with the selected integrator
+void PhysicsScene::runFrictionAndWalls() {
+    if (m_integrator == SIMD_INTEGRATOR) {
+        BallIntegrator::dampAndBounce(m_balls, m_tableExtents, 0.99f, m_continuousCollision);
+    }
+    else {
+        applyFrictionAndWalls();
+    }
+}
+
+// Advance every ball's velocity and position
+void PhysicsScene::integrateBalls(float dt) {
+    float* x = m_balls.x.data();
+    float* y = m_balls.y.data();
+    float* vx = m_balls.vx.data();
+    float* vy = m_balls.vy.data();
+    const unsigned char* sleeping = m_balls.sleeping.data();
+    size_t count = m_balls.size();
+
+    for (size_t i = 0; i < count; ++i) {
+        if (sleeping[i]) continue;
+        vx[i] += m_gravity.x * dt;
+        vy[i] += m_gravity.y * dt;
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+// Swept collision between two balls that moved in a straight line for the last dt seconds
+bool PhysicsScene::sweptBall2Ball(BallArrays& balls, unsigned int i, unsigned int j, float dt) {
+    // Relative motion over the step: gap(t) = startGap + relativeVelocity * t for t in [0, dt]
+    float relativeVelocityX = balls.vx[j] - balls.vx[i];
+    float relativeVelocityY = balls.vy[j] - balls.vy[i];
+    float startGapX = (balls.x[j] - balls.x[i]) - relativeVelocityX * dt;
+    float startGapY = (balls.y[j] - balls.y[i]) - relativeVelocityY * dt;
+    float contactDistance = balls.radius[i] + balls.radius[j];
+
+    // Solve |gap(t)|^2 = contactDistance^2 for the first time of impact
+    float a = relativeVelocityX * relativeVelocityX + relativeVelocityY * relativeVelocityY;
+    float b = 2.0f * (startGapX * relativeVelocityX + startGapY * relativeVelocityY);
+    float c = startGapX * startGapX + startGapY * startGapY - contactDistance * contactDistance;
+    float discriminant = b * b - 4.0f * a * c;
+    if (c <= 0.0f || a == 0.0f || b >= 0.0f || discriminant < 0.0f) {
+        // Already touching at the start of the step, or never approaching: resolve any overlap directly
+        return ball2Ball(balls, i, j);
+    }
+    float timeOfImpact = (-b - std::sqrt(discriminant)) / (2.0f * a);
+    if (timeOfImpact > dt) {
+        return false;
+    }
+
+    // Rewind both balls to the moment of impact
+    float remaining = dt - timeOfImpact;
+    balls.x[i] -= balls.vx[i] * remaining;
+    balls.y[i] -= balls.vy[i] * remaining;
+    balls.x[j] -= balls.vx[j] * remaining;
+    balls.y[j] -= balls.vy[j] * remaining;
+
+    // Bounce them with the same impulse as ball2Ball (they are exactly touching, so no separation is needed)
+    float normalX = (startGapX + relativeVelocityX * timeOfImpact) / contactDistance;
+    float normalY = (startGapY + relativeVelocityY * timeOfImpact) / contactDistance;
+    float restitution = 0.8f;
+    float impulseMagnitude = (-(1.0f + restitution) * (relativeVelocityX * normalX + relativeVelocityY * normalY)) /
+        (balls.invMass[i] + balls.invMass[j]);
+    float impulseX = impulseMagnitude * normalX;
+    float impulseY = impulseMagnitude * normalY;
+    balls.vx[i] -= impulseX * balls.invMass[i];
+    balls.vy[i] -= impulseY * balls.invMass[i];
+    balls.vx[j] += impulseX * balls.invMass[j];
+    balls.vy[j] += impulseY * balls.invMass[j];
+
+    // Carry on for the rest of the step with the new velocities
+    balls.x[i] += balls.vx[i] * remaining;
+    balls.y[i] += balls.vy[i] * remaining;
+    balls.x[j] += balls.vx[j] * remaining;
+    balls.y[j] += balls.vy[j] * remaining;
+
+    return true;
+}
+
+// Collide one pair of balls and wake both if they touched
+bool PhysicsScene::collideBallPair(unsigned int i, unsigned int j, float dt) {
+    if (m_dispatch == RTTI_DISPATCH) {
+        // Rediscover that both sides are spheres the way the engine used to, before trusting the slots
+        PhysicsObject* obj1 = m_balls.handles[i];
+        PhysicsObject* obj2 = m_balls.handles[j];
+        if (!dynamic_cast<Sphere*>(obj1) || !dynamic_cast<Sphere*>(obj2)) {
+            return false;
+        }
+    }
+    bool touched = m_continuousCollision ? sweptBall2Ball(m_balls, i, j, dt) : ball2Ball(m_balls, i, j);
+    if (touched) {
+        wakeBall(i);
+        wakeBall(j);
+    }
+    return touched;
+}
+
+// Collide every candidate pair of spheres found by the selected broadphase.
+// Both sides are known to be balls, so pairs go straight to ball2Ball rather than through the function array.
+// Two sleeping balls cannot have moved into each other, so only pairs with at least one awake ball are tested.
+void PhysicsScene::collideSpheres(float dt) {
+    size_t count = m_balls.size();
+    const unsigned char* sleeping = m_balls.sleeping.data();
+    m_candidatePairCount = 0;
+    m_touchedPairs.clear();
+
+    if (m_broadphase == BRUTE_FORCE) {
+        for (unsigned int i = 0; i < count; ++i) {
+            for (unsigned int j = i + 1; j < count; ++j) {
+                if (sleeping[i] && sleeping[j]) continue;
+                m_candidatePairCount++;
+                if (collideBallPair(i, j, dt) && isLogging()) {
+                    m_touchedPairs.push_back({ i, j });
+                }
+            }
+        }
+        logCollisions();
+        return;
+    }
+
+    // Size the cells from the largest radius so overlapping balls always land in the same or neighbouring cells
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < count; ++i) {
+        maxRadius = std::max(maxRadius, m_balls.radius[i]);
+    }
+
+    if (m_continuousCollision) {
+        // Bucket each ball by the midpoint of its path over the step and grow the cells by the longest path,
+        // so any two balls whose swept paths come within contact distance are still in neighbouring cells
+        m_sweepX.resize(count);
+        m_sweepY.resize(count);
+        float maxTravel = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            m_sweepX[i] = m_balls.x[i] - m_balls.vx[i] * dt * 0.5f;
+            m_sweepY[i] = m_balls.y[i] - m_balls.vy[i] * dt * 0.5f;
+            maxTravel = std::max(maxTravel, std::sqrt(m_balls.vx[i] * m_balls.vx[i] + m_balls.vy[i] * m_balls.vy[i]) * dt);
+        }
+        m_grid.build(m_sweepX.data(), m_sweepY.data(), count, maxRadius * 2.0f + maxTravel);
+    }
+    else {
+        m_grid.build(m_balls.x.data(), m_balls.y.data(), count, maxRadius * 2.0f);
+    }
+    // Sleeping balls stay in the grid so awake balls can hit (and wake) them, but are never queried themselves
+    m_candidatePairs.clear();
+    m_grid.findPairs(m_candidatePairs, m_awakeCount < count ? sleeping : nullptr);
+    m_candidatePairCount = m_candidatePairs.size();
+
+    if (m_narrowphase == SIMD_NARROWPHASE) {
+        m_pairKernel.schedule(m_candidatePairs, count);
+        m_pairKernel.collide(m_balls, m_candidatePairs, dt, m_continuousCollision, m_pairTouched, m_threadPool.get());
+        if (m_awakeCount < count) {
+            for (size_t k = 0; k < m_candidatePairs.size(); ++k) {
+                if (m_pairTouched[k]) {
+                    wakeBall(m_candidatePairs[k].a);
+                    wakeBall(m_candidatePairs[k].b);
+                }
+            }
+        }
+    }
+    else {
+        m_pairTouched.resize(m_candidatePairs.size());
+        for (size_t k = 0; k < m_candidatePairs.size(); ++k) {
+            m_pairTouched[k] = collideBallPair(m_candidatePairs[k].a, m_candidatePairs[k].b, dt);
+        }
+    }
+
+    if (isLogging()) {
+        for (size_t k = 0; k < m_candidatePairs.size(); ++k) {
+            if (m_pairTouched[k]) {
+                m_touchedPairs.push_back(m_candidatePairs[k]);
+            }
+        }
+    }
+    logCollisions();
+}
+
+// Collide every pair involving a non-ball actor, dispatching on the shapes through the collision function array
+void PhysicsScene::collideOtherActors() {
+    for (size_t i = 0; i < m_otherActors.size(); ++i) {
+        PhysicsObject* obj1 = m_otherActors[i];
+        int shape1 = obj1->getShapeID();
+
+        for (size_t j = i + 1; j < m_otherActors.size(); ++j) {
+            PhysicsObject* obj2 = m_otherActors[j];
+            fn collisionFunction = collisionFunctionArray[shape1 * SHAPE_COUNT + obj2->getShapeID()];
+            if (collisionFunction) {
+                collisionFunction(obj1, obj2);
+            }
+        }
+
+        fn ballFunction = collisionFunctionArray[shape1 * SHAPE_COUNT + SPHERE];
+        if (ballFunction) {
+            for (Sphere* ball : m_balls.handles) {
+                ballFunction(obj1, ball);
+            }
+        }
+    }
+}
+
+// Apply friction to every ball and bounce balls off the table boundary
+void PhysicsScene::applyFrictionAndWalls() {
+    float* x = m_balls.x.data();
+    float* y = m_balls.y.data();
+    float* vx = m_balls.vx.data();
+    float* vy = m_balls.vy.data();
+    const float* radius = m_balls.radius.data();
+    size_t count = m_balls.size();
+    float extentX = m_tableExtents.x;
+    float extentY = m_tableExtents.y;
+    float frictionCoefficient = 0.99f;
+
+    for (size_t i = 0; i < count; ++i) {
+        if (m_balls.sleeping[i]) continue;
+        float velocityX = vx[i];
+        float velocityY = vy[i];
+
+        // Apply friction
+        vx[i] = velocityX * frictionCoefficient;
+        vy[i] = velocityY * frictionCoefficient;
+
+        // Boundary collision detection. A bounce replaces the damped velocity with the
+        // reflected pre-friction velocity, matching the original per-actor loop.
+        bool hitX = x[i] - radius[i] < -extentX || x[i] + radius[i] > extentX;
+        bool hitY = y[i] - radius[i] < -extentY || y[i] + radius[i] > extentY;
+        if (hitX || hitY) {
+            vx[i] = hitX ? -velocityX : velocityX;
+            vy[i] = hitY ? -velocityY : velocityY;
+        }
+        if (hitX) {
+            if (m_continuousCollision) {
+                // Reflect the overshoot back onto the table, as if the ball bounced the moment it touched the cushion
+                x[i] = x[i] - radius[i] < -extentX ? 2.0f * (-extentX + radius[i]) - x[i] : 2.0f * (extentX - radius[i]) - x[i];
+            }
+            if (x[i] - radius[i] < -extentX) x[i] = -extentX + radius[i];
+            if (x[i] + radius[i] > extentX) x[i] = extentX - radius[i];
+        }
+        if (hitY) {
+            if (m_continuousCollision) {
+                y[i] = y[i] - radius[i] < -extentY ? 2.0f * (-extentY + radius[i]) - y[i] : 2.0f * (extentY - radius[i]) - y[i];
+            }
+            if (y[i] - radius[i] < -extentY) y[i] = -extentY + radius[i];
+            if (y[i] + radius[i] > extentY) y[i] = extentY - radius[i];
+        }
+    }
+}
+
+// Record every ball whose centre is inside a pocket
+void PhysicsScene::detectPockets() {
+    for (size_t i = 0; i < m_balls.size(); ++i) {
+        if (m_balls.sleeping[i]) continue;
+        for (size_t p = 0; p < m_pockets.size(); ++p) {
+            const Pocket& pocket = m_pockets[p];
+            float deltaX = m_balls.x[i] - pocket.position.x;
+            float deltaY = m_balls.y[i] - pocket.position.y;
+            if (m_continuousCollision) {
+                // Use the closest point to the pocket along the ball's path this step, so a fast ball cannot skip over it
+                float pathX = m_balls.x[i] - m_balls.previousX[i];
+                float pathY = m_balls.y[i] - m_balls.previousY[i];
+                float pathLengthSquared = pathX * pathX + pathY * pathY;
+                if (pathLengthSquared > 0.0f) {
+                    float t = std::min(std::max((deltaX * pathX + deltaY * pathY) / pathLengthSquared, 0.0f), 1.0f);
+                    deltaX -= pathX * t;
+                    deltaY -= pathY * t;
+                }
+            }
+            if (std::sqrt(deltaX * deltaX + deltaY * deltaY) < pocket.radius) {
+                // A ball stays in the pocket over the remaining substeps of an update, so only report it once
+                Sphere* ball = m_balls.handles[i];
+                if (std::find(m_pocketedBalls.begin(), m_pocketedBalls.end(), ball) == m_pocketedBalls.end()) {
+                    m_pocketedBalls.push_back(ball);
+                    if (isLogging()) {
+                        logEvent(POCKET_EVENT, (unsigned int)i, (unsigned int)p, m_balls.x[i], m_balls.y[i],
+                            std::sqrt(m_balls.vx[i] * m_balls.vx[i] + m_balls.vy[i] * m_balls.vy[i]));
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Push an event into the event log and the kept events, whichever are in use
+void PhysicsScene::pushEvent(const PhysicsEvent& event) {
+    if (m_eventLog) {
+        m_eventLog->push(event);
+    }
+    if (m_keepEvents) {
+        m_events.push_back(event);
+    }
+}
+
+// Push an event stamped with the current time
+void PhysicsScene::logEvent(PhysicsEventType type, unsigned int ball, unsigned int other, float x, float y, float speed) {
+    pushEvent({ m_time, type, ball, other, x, y, speed });
+}
+
+// Log every pair that touched this step.
+// This runs once all pairs are resolved, whichever broadphase and narrowphase found them, so every contact is logged
+// with the balls where they ended up and every combination logs the same events.
+void PhysicsScene::logCollisions() {
+    if (!isLogging()) {
+        return;
+    }
+    for (const CandidatePair& pair : m_touchedPairs) {
+        logCollision(pair.a, pair.b);
+    }
+}
+
+// Log a contact between two balls.
+// The narrowphases only report which pairs touched, so the closing speed is worked out from the velocities saved
+// before contacts were resolved, along the line between the balls where they ended up. Balls that were not closing
+// in (e.g. a resting rack being pushed apart) made no impact and are not logged.
+void PhysicsScene::logCollision(unsigned int i, unsigned int j) {
+    float deltaX = m_balls.x[j] - m_balls.x[i];
+    float deltaY = m_balls.y[j] - m_balls.y[i];
+    float distance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+    if (distance == 0.0f) {
+        return;
+    }
+    float normalX = deltaX / distance;
+    float normalY = deltaY / distance;
+    float approach = (m_eventVx[i] - m_eventVx[j]) * normalX + (m_eventVy[i] - m_eventVy[j]) * normalY;
+    if (approach <= 0.0f) {
+        return;
+    }
+    float contact = m_balls.radius[i] / (m_balls.radius[i] + m_balls.radius[j]);
+    logEvent(COLLISION_EVENT, i, j, m_balls.x[i] + deltaX * contact, m_balls.y[i] + deltaY * contact, approach);
+}
+
+// Log every ball the cushion pass bounced.
+// Friction only scales a velocity, so a component that changed sign over the pass was reflected by a cushion.
+void PhysicsScene::logCushions() {
+    const float* vx = m_balls.vx.data();
+    const float* vy = m_balls.vy.data();
+    for (size_t i = 0; i < m_balls.size(); ++i) {
+        if (m_balls.sleeping[i]) continue;
+        if (vx[i] * m_eventVx[i] < 0.0f) {
+            unsigned int cushion = m_balls.x[i] > 0.0f ? 1 : 0;
+            logEvent(CUSHION_EVENT, (unsigned int)i, cushion, cushion ? m_tableExtents.x : -m_tableExtents.x, m_balls.y[i],
+                std::fabs(m_eventVx[i]));
+        }
+        if (vy[i] * m_eventVy[i] < 0.0f) {
+            unsigned int cushion = m_balls.y[i] > 0.0f ? 3 : 2;
+            logEvent(CUSHION_EVENT, (unsigned int)i, cushion, m_balls.x[i], cushion == 3 ? m_tableExtents.y : -m_tableExtents.y,
+                std::fabs(m_eventVy[i]));
+        }
+    }
+}
+
+// Put balls that have slowed below the sleep speed to sleep
+void PhysicsScene::updateSleepState() {
+    if (m_solver == EVENT_DRIVEN) {
+        // The event solver brings balls exactly to rest itself, so just mirror its state
+        m_awakeCount = 0;
+        for (size_t i = 0; i < m_balls.size(); ++i) {
+            float speed = std::sqrt(m_balls.vx[i] * m_balls.vx[i] + m_balls.vy[i] * m_balls.vy[i]);
+            m_balls.sleeping[i] = speed <= m_sleepSpeed;
+            m_awakeCount += !m_balls.sleeping[i];
+        }
+        return;
+    }
+
+    if (m_gravity != glm::vec2(0, 0)) {
+        return;
+    }
+    for (size_t i = 0; i < m_balls.size(); ++i) {
+        if (m_balls.sleeping[i]) continue;
+        float speed = std::sqrt(m_balls.vx[i] * m_balls.vx[i] + m_balls.vy[i] * m_balls.vy[i]);
+        if (speed <= m_sleepSpeed) {
+            m_balls.vx[i] = 0.0f;
+            m_balls.vy[i] = 0.0f;
+            m_balls.sleeping[i] = 1;
+            m_awakeCount--;
+        }
+    }
+}
+
+// Update the physics scene by a frame of dt seconds
+void PhysicsScene::update(float dt) {
+    m_pocketedBalls.clear();
+    m_events.clear();
+
+    // The event-driven solver is exact for any interval, so it simply advances by the frame time
+    if (m_solver == EVENT_DRIVEN) {
+        simulateAndRecord(dt);
+        m_accumulator = 0.0f;
+        m_interpolation = 1.0f;
+        m_substepCount = 1;
+        return;
+    }
+
+    // Run whole fixed steps out of the accumulated frame time, so step cost does not depend on frame rate
+    m_accumulator += dt;
+    m_substepCount = 0;
+    while (m_accumulator >= m_timeStep && m_substepCount < m_maxSubsteps) {
+        simulateAndRecord(m_timeStep);
+        m_accumulator -= m_timeStep;
+        m_substepCount++;
+    }
+
+    // Over budget (e.g. after a hitch): drop the backlog so the simulation slows down rather than spiralling
+    if (m_accumulator >= m_timeStep) {
+        m_accumulator = std::fmod(m_accumulator, m_timeStep);
+    }
+    m_interpolation = m_accumulator / m_timeStep;
+}
+
+// Advance the physics scene by exactly one step
+void PhysicsScene::step(float dt) {
+    m_pocketedBalls.clear();
+    m_events.clear();
+    simulateAndRecord(dt);
+}
+
+// Advance the simulation by dt, recording a replay frame at every fixed-step boundary it crosses
+void PhysicsScene::simulateAndRecord(float dt) {
+    if (!m_replayWriter || m_timeStep <= 0.0f) {
+        simulate(dt);
+        return;
+    }
+
+    // The event-driven solver can stop anywhere, so it stops on each boundary and records the state exactly there
+    if (m_solver == EVENT_DRIVEN) {
+        while (dt >= m_timeStep - m_replayClock) {
+            float toBoundary = m_timeStep - m_replayClock;
+            simulate(toBoundary);
+            m_replayWriter->record(*this);
+            m_replayClock = 0.0f;
+            dt -= toBoundary;
+        }
+        if (dt > 0.0f) {
+            simulate(dt);
+            m_replayClock += dt;
+        }
+        return;
+    }
+
+    // A fixed step cannot be split, so a step shorter than m_timeStep records nothing until a whole step has built
+    // up, and a longer one records its state once per boundary it crossed
+    simulate(dt);
+    m_replayClock += dt;
+    while (m_replayClock >= m_timeStep) {
+        m_replayWriter->record(*this);
+        m_replayClock -= m_timeStep;
+    }
+}
+
+// Advance the simulation by one step without clearing the pocketed list
+void PhysicsScene::simulate(float dt) {
+    // Update all actors that are not balls
+    for (auto actor : m_otherActors) {
+        actor->fixedUpdate(m_gravity, dt);
+    }
+
+    if (m_solver == EVENT_DRIVEN) {
+        // Jump from contact to contact; the solver reports pocketed balls (and, while logging, every contact) as it reaches them
+        m_pocketedSlots.clear();
+        m_solverEvents.clear();
+        m_eventSolver.advance(m_balls, m_pockets, m_tableExtents, dt, m_pocketedSlots, isLogging() ? &m_solverEvents : nullptr);
+        for (unsigned int slot : m_pocketedSlots) {
+            m_pocketedBalls.push_back(m_balls.handles[slot]);
+        }
+        for (PhysicsEvent& event : m_solverEvents) {
+            event.time += m_time;
+            pushEvent(event);
+        }
+        m_time += dt;
+        collideOtherActors();
+        updateSleepState();
+        return;
+    }
+
+    // Integrate the balls in one pass, remembering where each ball started so the renderer can interpolate between steps
+    runIntegrator(dt);
+
+    // Events are stamped with the time at the end of the step, where the balls now are
+    m_time += dt;
+
+    // Check for collisions
+    if (isLogging()) {
+        m_eventVx = m_balls.vx;
+        m_eventVy = m_balls.vy;
+    }
+    collideSpheres(dt);
+    collideOtherActors();
+
+    // Apply friction and boundary collisions
+    if (isLogging()) {
+        m_eventVx = m_balls.vx;
+        m_eventVy = m_balls.vy;
+    }
+    runFrictionAndWalls();
+    if (isLogging()) {
+        logCushions();
+    }
+
+    // Check for balls entering the pockets
+    detectPockets();
+
+    // Let balls that have come to rest drop out of the next step
+    updateSleepState();
+}
+
+// Get a ball's position interpolated between the last two fixed steps
+glm::vec2 PhysicsScene::getRenderPosition(unsigned int index) const {
+    if (m_solver == EVENT_DRIVEN) {
+        return glm::vec2(m_balls.x[index], m_balls.y[index]);
+    }
+    float alpha = m_interpolation;
+    return glm::vec2(m_balls.previousX[index] + (m_balls.x[index] - m_balls.previousX[index]) * alpha,
+        m_balls.previousY[index] + (m_balls.y[index] - m_balls.previousY[index]) * alpha);
+}
@@ -0,0 +1,362 @@
+#pragma once
+#include "glm/vec2.hpp"
+#include "SpatialGrid.h"
+#include "EventSolver.h"
+#include "BallPairKernel.h"
+#include "BallIntegrator.h"
+#include "EventLog.h"
+#include <vector>
+#include <memory>
+
+enum ShapeType {
+    PLANE = 0,
+    SPHERE,
+    BOX,
+    SHAPE_COUNT
+};
+
+// Strategy used to find which spheres need a narrowphase collision test
+enum BroadphaseType {
+    BRUTE_FORCE = 0, // Test every pair of spheres (O(n^2))
+    UNIFORM_GRID     // Only test spheres in the same or neighbouring grid cells
+};
+
+// Implementation used to resolve candidate ball pairs
+enum NarrowphaseType {
+    SCALAR_NARROWPHASE = 0, // One pair at a time (the reference implementation)
+    SIMD_NARROWPHASE        // Batches of pairs that share no ball, simd::kWidth at a time; bit-identical to SCALAR_NARROWPHASE
+};
+
+// Implementation used for the per-ball integrate and friction/cushion passes
+enum IntegratorType {
+    SCALAR_INTEGRATOR = 0, // One ball at a time (the reference implementation)
+    SIMD_INTEGRATOR        // simd::kWidth balls at a time; bit-identical to SCALAR_INTEGRATOR
+};
+
+// How a ball pair finds out the shapes of its two sides
+enum DispatchType {
+    SHAPE_TYPE_DISPATCH = 0, // Trust the ShapeType: ball pairs go straight to the ball routines
+    RTTI_DISPATCH            // dynamic_cast both sides of every pair first, as the engine did before ShapeType dispatch.
+                             // Only kept to benchmark against; it applies to the scalar narrowphase and BRUTE_FORCE
+};
+
+// Engine used to advance the balls
+enum SolverType {
+    FIXED_STEP = 0, // Integrate, collide and damp once per update
+    EVENT_DRIVEN    // Solve contact times analytically and jump from event to event
+};
+
+class Sphere;
+class ThreadPool;
+class ReplayWriter;
+
+// A circular pocket; a ball drops once its centre is inside the radius
+struct Pocket {
+    glm::vec2 position; // Centre of the pocket
+    float radius;       // Radius of the pocket
+};
+
+// Per-ball state owned by the scene, stored as a structure of arrays so the integrator,
+// friction, walls and narrowphase can run as linear passes over contiguous memory.
+// Slot i of every array belongs to the same ball, and slots follow the order balls were added.
+struct BallArrays {
+    std::vector<float> x;         // Position x
+    std::vector<float> y;         // Position y
+    std::vector<float> vx;        // Velocity x
+    std::vector<float> vy;        // Velocity y
+    std::vector<float> invMass;   // Inverse mass
+    std::vector<float> radius;    // Radius
+    std::vector<float> previousX; // Position x at the start of the last fixed step
+    std::vector<float> previousY; // Position y at the start of the last fixed step
+    std::vector<unsigned char> sleeping; // Non-zero while a ball is at rest and skipped by the fixed-step passes
+    std::vector<Sphere*> handles; // Sphere handle referring to each slot
+
+    // Gets the number of balls stored
+    size_t size() const { return x.size(); }
+};
+
+// Value copy of the changing state of a scene: the ball arrays (without their handles) and the clocks.
+// Saving and restoring are straight array copies, so a buffer reused across many restores never allocates.
+struct SceneSnapshot {
+    std::vector<float> x;         // Position x of each ball
+    std::vector<float> y;         // Position y of each ball
+    std::vector<float> vx;        // Velocity x of each ball
+    std::vector<float> vy;        // Velocity y of each ball
+    std::vector<float> invMass;   // Inverse mass of each ball
+    std::vector<float> radius;    // Radius of each ball
+    std::vector<float> previousX; // Position x of each ball at the start of the last fixed step
+    std::vector<float> previousY; // Position y of each ball at the start of the last fixed step
+    std::vector<unsigned char> sleeping; // Sleep flag of each ball
+    size_t awakeCount;   // Number of balls that were not sleeping
+    float accumulator;   // Frame time not yet consumed by fixed steps
+    float interpolation; // Render interpolation factor
+    int substepCount;    // Fixed steps run by the last update
+    double time;         // Simulation time since the scene was created
+
+    // Gets the number of balls stored
+    size_t size() const { return x.size(); }
+};
+
+// Base class for all physics objects
+class PhysicsObject
+{
+protected:
+    ShapeType m_shapeID; // Shape identifier for the physics object
+    PhysicsObject(ShapeType a_shapeID) : m_shapeID(a_shapeID) {}
+
+public:
+    // Virtual destructor so actors can be deleted through a PhysicsObject pointer
+    virtual ~PhysicsObject() {}
+
+    // Pure virtual function for updating the physics object
+    virtual void fixedUpdate(glm::vec2 gravity, float timeStep) = 0;
+    // Virtual function for resetting the position of the physics object
+    virtual void resetPosition() {};
+
+    // Getter for the shape identifier
+    ShapeType getShapeID() const { return m_shapeID; }
+};
+
+// Class for managing the physics scene
+class PhysicsScene
+{
+public:
+    PhysicsScene();
+    ~PhysicsScene();
+
+    // Adds a physics object to the scene
+    void addActor(PhysicsObject* actor);
+    // Removes a physics object from the scene
+    void removeActor(PhysicsObject* actor);
+    // Updates the physics scene by a frame of dt seconds, running as many fixed steps as fit (up to the substep budget)
+    void update(float dt);
+    // Advances the physics scene by exactly one step of dt seconds, bypassing the accumulator
+    void step(float dt);
+
+    // Checks if all balls have stopped moving
+    bool allBallsStopped() const { return m_awakeCount == 0; }
+    // Gets the number of balls that are still moving
+    size_t getAwakeCount() const { return m_awakeCount; }
+
+    // Sets the speed below which a ball is put to sleep at the end of a step; the event-driven solver also treats
+    // contacts closing slower than this as resting
+    void setSleepSpeed(float speed) { m_sleepSpeed = speed; m_eventSolver.setRestingSpeed(speed); }
+    // Gets the speed below which a ball is put to sleep
+    float getSleepSpeed() const { return m_sleepSpeed; }
+
+    // Sets the gravity for the physics scene (balls only sleep while there is no gravity)
+    void setGravity(const glm::vec2 gravity);
+    // Gets the gravity of the physics scene
+    glm::vec2 getGravity() const { return m_gravity; }
+
+    // Sets the time step for the physics scene
+    void setTimeStep(const float timeStep) { m_timeStep = timeStep; }
+    // Gets the time step of the physics scene
+    float getTimeStep() const { return m_timeStep; }
+
+    // Sets the most fixed steps a single update may run; time beyond the budget is dropped
+    void setMaxSubsteps(int maxSubsteps) { m_maxSubsteps = maxSubsteps; }
+    // Gets the most fixed steps a single update may run
+    int getMaxSubsteps() const { return m_maxSubsteps; }
+    // Gets the number of fixed steps run by the last update
+    int getSubstepCount() const { return m_substepCount; }
+    // Gets how far between the last two fixed steps the frame time lies (0 to 1)
+    float getInterpolation() const { return m_interpolation; }
+    // Gets a ball's position interpolated between the last two fixed steps, for rendering
+    glm::vec2 getRenderPosition(unsigned int index) const;
+    // Gets the simulation time since the scene was created, in seconds
+    double getTime() const { return m_time; }
+
+    // Sets the engine used to advance the balls
+    void setSolver(SolverType solver);
+    // Gets the engine used to advance the balls
+    SolverType getSolver() const { return m_solver; }
+    // Gets the event-driven solver (used when the solver is EVENT_DRIVEN)
+    EventSolver& getEventSolver() { return m_eventSolver; }
+    const EventSolver& getEventSolver() const { return m_eventSolver; }
+
+    // Sets the half extents of the table; balls bounce off cushions at +/- these values
+    void setTableExtents(const glm::vec2& extents) { m_tableExtents = extents; }
+    // Gets the half extents of the table
+    glm::vec2 getTableExtents() const { return m_tableExtents; }
+
+    // Adds a pocket to the table
+    void addPocket(const glm::vec2& position, float radius) { m_pockets.push_back({ position, radius }); }
+    // Gets the pockets of the table
+    const std::vector<Pocket>& getPockets() const { return m_pockets; }
+    // Gets the balls that dropped into a pocket during the last update
+    const std::vector<Sphere*>& getPocketedBalls() const { return m_pocketedBalls; }
+
+    // Notifies the scene that a ball's state was changed from outside the solver, waking it up.
+    // Call this after writing to the ball arrays directly.
+    void markBallChanged(unsigned int index);
+    // Copies the state of every ball, and the clocks, into snapshot (reusing its storage)
+    void saveSnapshot(SceneSnapshot& snapshot) const;
+    // Puts every ball back to the state in snapshot. The scene must still hold the balls it held when the snapshot
+    // was saved (same count, same order); returns false and changes nothing otherwise.
+    bool restoreSnapshot(const SceneSnapshot& snapshot);
+
+    // Puts a ball to sleep straight away, stopping it (used to copy a table that is already at rest)
+    void sleepBall(unsigned int index);
+
+    // Enables swept (time-of-impact) collisions against other balls, cushions and pockets, so large steps cannot tunnel
+    void setContinuousCollision(bool enabled) { m_continuousCollision = enabled; }
+    // Checks whether swept collisions are enabled
+    bool getContinuousCollision() const { return m_continuousCollision; }
+
+    // Sets the broadphase used to find candidate sphere pairs
+    void setBroadphase(BroadphaseType broadphase) { m_broadphase = broadphase; }
+    // Gets the broadphase used to find candidate sphere pairs
+    BroadphaseType getBroadphase() const { return m_broadphase; }
+    // Sets the implementation used to resolve candidate pairs from the UNIFORM_GRID broadphase
+    // (BRUTE_FORCE always resolves pairs one at a time)
+    void setNarrowphase(NarrowphaseType narrowphase) { m_narrowphase = narrowphase; }
+    // Gets the implementation used to resolve candidate pairs
+    NarrowphaseType getNarrowphase() const { return m_narrowphase; }
+    // Sets how ball pairs find out the shapes of their two sides
+    void setDispatch(DispatchType dispatch) { m_dispatch = dispatch; }
+    // Gets how ball pairs find out the shapes of their two sides
+    DispatchType getDispatch() const { return m_dispatch; }
+    // Sets the implementation used for the per-ball integrate and friction/cushion passes
+    void setIntegrator(IntegratorType integrator) { m_integrator = integrator; }
+    // Gets the implementation used for the per-ball passes
+    IntegratorType getIntegrator() const { return m_integrator; }
+    // Runs only the per-ball integrate and friction/cushion passes of a fixed step with the selected integrator,
+    // skipping collisions, pockets and sleep (lets the benchmark time the two integrators on their own)
+    void stepIntegrator(float dt);
+    // Sets how many threads resolve ball contacts (including the calling thread; 0 and 1 both mean no extra threads).
+    // Only the SIMD narrowphase is split across threads, and the result is identical for every worker count.
+    void setWorkerCount(unsigned int workerCount);
+    // Gets how many threads resolve ball contacts
+    unsigned int getWorkerCount() const;
+    // Gets the number of sphere pairs handed to the narrowphase during the last update
+    size_t getCandidatePairCount() const { return m_candidatePairCount; }
+    // Sets a replay to record a frame into at every fixed-step boundary (not owned; nullptr stops recording).
+    // Frames are always getTimeStep() apart, whatever intervals update or step advance the scene by.
+    void setReplayWriter(ReplayWriter* writer) { m_replayWriter = writer; m_replayClock = 0.0f; }
+    // Gets the replay recording this scene, if any
+    ReplayWriter* getReplayWriter() const { return m_replayWriter; }
+    // Sets a log to push every ball collision, cushion bounce and pocket into as they happen
+    // (not owned; nullptr stops logging). Logging never blocks a step.
+    void setEventLog(EventLog* log) { m_eventLog = log; }
+    // Gets the log receiving this scene's events, if any
+    EventLog* getEventLog() const { return m_eventLog; }
+    // Sets whether the scene keeps every ball collision, cushion bounce and pocket of the last update in memory, as it
+    // would push them into an event log, so a caller can inspect them without one
+    void setKeepEvents(bool keep) { m_keepEvents = keep; }
+    // Gets the events kept during the last update (empty unless setKeepEvents is on)
+    const std::vector<PhysicsEvent>& getEvents() const { return m_events; }
+
+    // Gets the list of physics objects in the scene
+    const std::vector<PhysicsObject*>& getActors() const { return m_actors; }
+    // Gets the contiguous state of every sphere in the scene
+    BallArrays& getBalls() { return m_balls; }
+    const BallArrays& getBalls() const { return m_balls; }
+
+    // Collision detection functions
+    static bool plane2Plane(PhysicsObject*, PhysicsObject*);
+    static bool plane2Sphere(PhysicsObject*, PhysicsObject*);
+    static bool sphere2Plane(PhysicsObject*, PhysicsObject*);
+    static bool sphere2Sphere(PhysicsObject*, PhysicsObject*);
+    // Collision detection and response between two balls stored in the same arrays
+    static bool ball2Ball(BallArrays& balls, unsigned int i, unsigned int j);
+    // Swept collision between two balls that moved in a straight line for the last dt seconds.
+    // Balls that first touched during the step are rewound to the moment of impact, bounced, and moved on
+    // for the rest of the step; balls that were already overlapping fall back to ball2Ball.
+    static bool sweptBall2Ball(BallArrays& balls, unsigned int i, unsigned int j, float dt);
+
+protected:
+    glm::vec2 m_gravity; // Gravity vector for the physics scene
+    float m_timeStep; // Time step for the physics scene
+    float m_accumulator; // Frame time not yet consumed by fixed steps
+    float m_interpolation; // Fraction of a fixed step left in the accumulator after the last update
+    int m_maxSubsteps; // Most fixed steps a single update may run
+    int m_substepCount; // Fixed steps run by the last update
+    double m_time; // Simulation time since the scene was created
+    std::vector<PhysicsObject*> m_actors; // List of physics objects in the scene
+    std::vector<PhysicsObject*> m_otherActors; // Actors that are not stored in the ball arrays
+    BallArrays m_balls; // State of every sphere in the scene
+
+    SolverType m_solver; // Engine used to advance the balls
+    EventSolver m_eventSolver; // Engine used when m_solver is EVENT_DRIVEN
+    glm::vec2 m_tableExtents; // Half extents of the table
+    std::vector<Pocket> m_pockets; // Pockets of the table
+    std::vector<Sphere*> m_pocketedBalls; // Balls that dropped into a pocket during the last update
+
+    bool m_continuousCollision; // Whether balls are swept against each other, cushions and pockets
+    BroadphaseType m_broadphase; // Broadphase used to find candidate sphere pairs
+    NarrowphaseType m_narrowphase; // Implementation used to resolve candidate pairs
+    IntegratorType m_integrator; // Implementation used for the per-ball passes
+    DispatchType m_dispatch; // How ball pairs find out the shapes of their two sides
+    size_t m_candidatePairCount; // Number of pairs tested by the narrowphase last update
+
+    size_t m_awakeCount; // Number of balls that are not sleeping
+    float m_sleepSpeed; // Speed below which a ball falls asleep
+    ReplayWriter* m_replayWriter; // Replay recording every step (not owned; null when not recording)
+    float m_replayClock; // Time simulated since the last replay frame
+    EventLog* m_eventLog; // Log receiving contact events (not owned; null when not logging)
+    bool m_keepEvents; // Whether contact events are kept in m_events
+    std::vector<PhysicsEvent> m_events; // Contact events of the last update (only kept while m_keepEvents is set)
+
+private:
+    // Copies a sphere's state into a new ball slot and points the sphere at it
+    void addBall(Sphere* sphere);
+    // Copies a ball's state back into its sphere and removes the slot
+    void removeBall(unsigned int index);
+
+    // Advances the simulation by one step without clearing the pocketed list
+    void simulate(float dt);
+    // Advances the simulation by dt and records every replay frame that falls due in it
+    void simulateAndRecord(float dt);
+
+    // Saves every ball's previous position and advances its velocity and position with the selected integrator
+    void runIntegrator(float dt);
+    // Applies friction and bounces balls off the table boundary with the selected integrator
+    void runFrictionAndWalls();
+    // Advances every ball's velocity and position
+    void integrateBalls(float dt);
+    // Collides every candidate pair of spheres found by the selected broadphase
+    void collideSpheres(float dt);
+    // Collides one pair of balls, swept or discrete depending on the continuous collision setting,
+    // and wakes both if they touched; returns whether they touched
+    bool collideBallPair(unsigned int i, unsigned int j, float dt);
+    // Collides every pair involving a non-ball actor through the collision function array
+    void collideOtherActors();
+    // Applies friction to every ball and bounces balls off the table boundary
+    void applyFrictionAndWalls();
+    // Records every ball whose centre is (or, with continuous collision, passed) inside a pocket
+    void detectPockets();
+    // Puts balls that have slowed below the sleep speed to sleep
+    void updateSleepState();
+    // Wakes a sleeping ball
+    void wakeBall(unsigned int index);
+    // Checks whether contact events are wanted, by an event log or in m_events
+    bool isLogging() const { return m_eventLog || m_keepEvents; }
+    // Pushes an event into the event log and m_events, whichever are in use
+    void pushEvent(const PhysicsEvent& event);
+    // Pushes an event stamped with the current time
+    void logEvent(PhysicsEventType type, unsigned int ball, unsigned int other, float x, float y, float speed);
+    // Logs every pair in m_touchedPairs, once all pairs of the step are resolved
+    void logCollisions();
+    // Logs a contact between two balls, using their velocities from before contacts were resolved
+    void logCollision(unsigned int i, unsigned int j);
+    // Logs every ball whose velocity the cushion pass reflected, comparing against the velocities before it
+    void logCushions();
+
+    SpatialGrid m_grid; // Uniform grid used by the UNIFORM_GRID broadphase
+    std::vector<CandidatePair> m_candidatePairs; // Pairs produced by the grid this update
+    BallPairKernel m_pairKernel; // SIMD narrowphase used by SIMD_NARROWPHASE
+    std::unique_ptr<ThreadPool> m_threadPool; // Threads used to resolve contacts (null when running single-threaded)
+    std::vector<unsigned char> m_pairTouched; // Whether each candidate pair made contact this step
+    std::vector<CandidatePair> m_touchedPairs; // Pairs that made contact this step, in the order they were resolved (only kept while logging)
+    std::vector<float> m_sweepX; // Midpoint x of each ball's path over the step, used to build the grid
+    std::vector<float> m_sweepY; // Midpoint y of each ball's path over the step, used to build the grid
+    std::vector<unsigned int> m_pocketedSlots; // Slots pocketed by the event solver this update
+    std::vector<float> m_eventVx; // Velocity x of each ball before the pass being logged (only kept while logging)
+    std::vector<float> m_eventVy; // Velocity y of each ball before the pass being logged (only kept while logging)
+    std::vector<PhysicsEvent> m_solverEvents; // Events reported by the event solver this step (only kept while logging)
+
+    // Function pointer array for collision detection
+    typedef bool(*fn)(PhysicsObject*, PhysicsObject*);
+    static fn collisionFunctionArray[SHAPE_COUNT * SHAPE_COUNT];
+};
\ No newline at end of file
@@ -1,9 +1,7 @@
 #pragma once
 #include "glm/vec2.hpp"
 #include "glm/vec4.hpp"
-#include "Application.h"
 #include "PhysicsScene.h"
-#include "Gizmos.h"
 
 // Class representing a plane in the physics simulation
 class Plane : public PhysicsObject
@@ -16,8 +14,6 @@ public:
 
     // Updates the plane's physics
     virtual void fixedUpdate(glm::vec2 gravity, float timeStep);
-    // Draws the plane
-    virtual void draw();
     // Resets the plane's position
     virtual void resetPosition();
 
@@ -31,6 +27,9 @@ public:
     // Setter for the plane's distance to the origin
     void setDistance(float distance) { m_distanceToOrigin = distance; }
 
+    // Getter for the plane's colour
+    glm::vec4 getColour() const { return m_colour; }
+
 protected:
     glm::vec2 m_normal; // Normal vector of the plane
     float m_distanceToOrigin; // Distance from the plane to the origin
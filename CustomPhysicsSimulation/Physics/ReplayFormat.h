@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Binary replay layout shared by ReplayWriter and ReplayReader.
+//
+// A file is a header, one frame per fixed step, and a footer indexing the keyframes. Positions and velocities
+// are quantized to integer multiples of the header's quanta. Every frame stores, per ball, the residual between
+// its quantized values and a prediction from the two frames before (the last value plus the last change), so balls
+// rolling at a steady rate or at rest cost next to nothing. Keyframes store the values themselves and reset the
+// prediction, so a reader can start decoding at any keyframe. Multi-byte fields are little-endian; integers are zigzag LEB128 varints.
+//
+// Keyframe: FRAME_KEY, varint ball count, then per ball radius (float32) and colour (RGBA8),
+//           then the sleeping bitmask, then per ball zigzag varints of quantized x, y, vx, vy.
+// Delta:    FRAME_DELTA, the sleeping bitmask, a changed bitmask, then for each changed ball zigzag varints of the
+//           residuals of x, y, vx, vy (a ball with all four residuals zero is left out).
+// Footer:   one index entry (frame number, file offset) per keyframe, in frame order, then the trailer, so a reader
+//           can find the keyframe before any frame with a binary search instead of decoding the whole file.
+namespace replay {
+
+const char kMagic[4] = { 'B', 'P', 'R', 'P' }; // Identifies a replay file
+const uint32_t kVersion = 2; // Format version written into the header (2 added the keyframe index footer)
+const int kChannels = 4; // Quantized values per ball: x, y, vx, vy
+
+// Frame type tags
+enum FrameType : uint8_t {
+    FRAME_KEY = 0,   // Absolute values
+    FRAME_DELTA = 1, // Residuals against the prediction from the previous frames
+};
+
+// File header
+struct FileHeader {
+    char magic[4];             // kMagic
+    uint32_t version;          // kVersion
+    float timeStep;            // Fixed step between frames, in seconds
+    float positionQuantum;     // Size of one position unit
+    float velocityQuantum;     // Size of one velocity unit
+    uint32_t keyframeInterval; // Frames between keyframes (a keyframe is also written whenever the ball count changes)
+};
+const size_t kHeaderSize = 24; // Bytes the header takes on disk
+
+// Appends the header to a buffer
+inline void writeHeader(std::vector<unsigned char>& out, const FileHeader& header) {
+    unsigned char bytes[kHeaderSize];
+    std::memcpy(bytes, header.magic, 4);
+    std::memcpy(bytes + 4, &header.version, 4);
+    std::memcpy(bytes + 8, &header.timeStep, 4);
+    std::memcpy(bytes + 12, &header.positionQuantum, 4);
+    std::memcpy(bytes + 16, &header.velocityQuantum, 4);
+    std::memcpy(bytes + 20, &header.keyframeInterval, 4);
+    out.insert(out.end(), bytes, bytes + kHeaderSize);
+}
+
+// Reads the header from the start of a file; returns false if it is too short or not a replay of this version
+inline bool readHeader(const unsigned char* data, size_t size, FileHeader& header) {
+    if (size < kHeaderSize) {
+        return false;
+    }
+    std::memcpy(header.magic, data, 4);
+    std::memcpy(&header.version, data + 4, 4);
+    std::memcpy(&header.timeStep, data + 8, 4);
+    std::memcpy(&header.positionQuantum, data + 12, 4);
+    std::memcpy(&header.velocityQuantum, data + 16, 4);
+    std::memcpy(&header.keyframeInterval, data + 20, 4);
+    return std::memcmp(header.magic, kMagic, 4) == 0 && header.version == kVersion;
+}
+
+// Where a keyframe starts, as stored in the footer index
+struct KeyframeEntry {
+    uint64_t frame;  // Frame number of the keyframe
+    uint64_t offset; // Offset of its FRAME_KEY tag from the start of the file
+};
+const size_t kKeyframeEntrySize = 16; // Bytes an index entry takes on disk
+
+// End of the file, which locates the index
+struct FileTrailer {
+    uint64_t frameCount;    // Frames in the file
+    uint64_t indexOffset;   // Offset of the first index entry (which is also where the frames end)
+    uint64_t keyframeCount; // Entries in the index
+    char magic[4];          // kTrailerMagic
+};
+const char kTrailerMagic[4] = { 'B', 'P', 'R', 'I' }; // Marks a complete file (a recording that was never closed has none)
+const size_t kTrailerSize = 32; // Bytes the trailer takes on disk (the last four are padding)
+
+// Appends an index entry to a buffer
+inline void writeKeyframeEntry(std::vector<unsigned char>& out, const KeyframeEntry& entry) {
+    unsigned char bytes[kKeyframeEntrySize];
+    std::memcpy(bytes, &entry.frame, 8);
+    std::memcpy(bytes + 8, &entry.offset, 8);
+    out.insert(out.end(), bytes, bytes + kKeyframeEntrySize);
+}
+
+// Reads the index entry at data
+inline KeyframeEntry readKeyframeEntry(const unsigned char* data) {
+    KeyframeEntry entry;
+    std::memcpy(&entry.frame, data, 8);
+    std::memcpy(&entry.offset, data + 8, 8);
+    return entry;
+}
+
+// Appends the trailer to a buffer
+inline void writeTrailer(std::vector<unsigned char>& out, const FileTrailer& trailer) {
+    unsigned char bytes[kTrailerSize] = {};
+    std::memcpy(bytes, &trailer.frameCount, 8);
+    std::memcpy(bytes + 8, &trailer.indexOffset, 8);
+    std::memcpy(bytes + 16, &trailer.keyframeCount, 8);
+    std::memcpy(bytes + 24, trailer.magic, 4);
+    out.insert(out.end(), bytes, bytes + kTrailerSize);
+}
+
+// Reads the trailer from the end of a file; returns false if there is none or it does not fit the file
+inline bool readTrailer(const unsigned char* data, size_t size, FileTrailer& trailer) {
+    if (size < kHeaderSize + kTrailerSize) {
+        return false;
+    }
+    const unsigned char* bytes = data + size - kTrailerSize;
+    std::memcpy(&trailer.frameCount, bytes, 8);
+    std::memcpy(&trailer.indexOffset, bytes + 8, 8);
+    std::memcpy(&trailer.keyframeCount, bytes + 16, 8);
+    std::memcpy(trailer.magic, bytes + 24, 4);
+    return std::memcmp(trailer.magic, kTrailerMagic, 4) == 0 && trailer.indexOffset >= kHeaderSize &&
+        trailer.indexOffset <= size - kTrailerSize &&
+        trailer.keyframeCount == (size - kTrailerSize - trailer.indexOffset) / kKeyframeEntrySize &&
+        (size - kTrailerSize - trailer.indexOffset) % kKeyframeEntrySize == 0;
+}
+
+// Appends a signed value as a zigzag LEB128 varint (small magnitudes of either sign take one byte)
+inline void writeVarint(std::vector<unsigned char>& out, int64_t value) {
+    uint64_t bits = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while (bits >= 0x80) {
+        out.push_back((unsigned char)(bits | 0x80));
+        bits >>= 7;
+    }
+    out.push_back((unsigned char)bits);
+}
+
+// Reads a zigzag LEB128 varint at cursor, advancing it; returns false if the varint runs past end
+inline bool readVarint(const unsigned char*& cursor, const unsigned char* end, int64_t& value) {
+    uint64_t bits = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (cursor == end) {
+            return false;
+        }
+        unsigned char byte = *cursor++;
+        bits |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            value = (int64_t)(bits >> 1) ^ -(int64_t)(bits & 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Gets the number of bytes in a bitmask of count bits
+inline size_t bitmaskBytes(size_t count) {
+    return (count + 7) / 8;
+}
+
+}
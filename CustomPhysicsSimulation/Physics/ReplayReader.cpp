@@ -0,0 +1,225 @@
+#include "ReplayReader.h"
+#include <iostream>
+#include <cmath>
+
+// Constructor for ReplayReader
+ReplayReader::ReplayReader() : m_offset(0), m_frameIndex(0) {
+    std::memset(&m_header, 0, sizeof(m_header));
+    std::memset(&m_trailer, 0, sizeof(m_trailer));
+}
+
+// Map a replay
+bool ReplayReader::open(const std::string& path) {
+    close();
+    if (!m_file.open(path)) {
+        return false;
+    }
+    if (!replay::readHeader(m_file.data(), m_file.size(), m_header)) {
+        std::cerr << path << " is not a replay this version can read" << std::endl;
+        close();
+        return false;
+    }
+    if (!replay::readTrailer(m_file.data(), m_file.size(), m_trailer) || m_trailer.keyframeCount == 0) {
+        std::cerr << path << " has no keyframe index (the recording was not closed)" << std::endl;
+        close();
+        return false;
+    }
+    if (m_trailer.frameCount == 0) {
+        std::cerr << path << " has no frames" << std::endl;
+        close();
+        return false;
+    }
+
+    // The first frame follows the header and is always a keyframe
+    m_offset = replay::kHeaderSize;
+    m_frameIndex = 0;
+    return true;
+}
+
+// Unmap the replay
+void ReplayReader::close() {
+    m_file.close();
+    std::memset(&m_trailer, 0, sizeof(m_trailer));
+    m_offset = 0;
+    m_frameIndex = 0;
+}
+
+// Move to a frame
+bool ReplayReader::seek(size_t frameIndex) {
+    if (!m_file.data()) {
+        return false;
+    }
+    if (frameIndex >= m_trailer.frameCount) {
+        frameIndex = m_trailer.frameCount > 0 ? (size_t)m_trailer.frameCount - 1 : 0;
+    }
+
+    // Find the last keyframe at or before the target with a binary search of the index
+    const unsigned char* index = m_file.data() + m_trailer.indexOffset;
+    size_t low = 0;
+    size_t high = (size_t)m_trailer.keyframeCount;
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (replay::readKeyframeEntry(index + middle * replay::kKeyframeEntrySize).frame <= frameIndex) {
+            low = middle;
+        }
+        else {
+            high = middle;
+        }
+    }
+    replay::KeyframeEntry keyframe = replay::readKeyframeEntry(index + low * replay::kKeyframeEntrySize);
+    if (keyframe.frame > frameIndex || keyframe.offset < replay::kHeaderSize || keyframe.offset >= m_trailer.indexOffset) {
+        std::cerr << "Replay keyframe index is damaged" << std::endl;
+        return false;
+    }
+
+    // Carrying on from the current position is cheaper when the target is ahead of it and no keyframe lies
+    // between them (e.g. stepping forward a frame at a time)
+    if (frameIndex < m_frameIndex || keyframe.frame > m_frameIndex) {
+        m_offset = (size_t)keyframe.offset;
+        m_frameIndex = (size_t)keyframe.frame;
+    }
+    while (m_frameIndex < frameIndex) {
+        if (!decodeFrame()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Move to the frame recorded at a time
+bool ReplayReader::seekTime(float seconds) {
+    if (seconds <= 0.0f || m_header.timeStep <= 0.0f) {
+        return seek(0);
+    }
+    return seek((size_t)std::floor(seconds / m_header.timeStep));
+}
+
+// Decode the next frame
+bool ReplayReader::readFrame(ReplayFrame& frame) {
+    if (!m_file.data() || m_frameIndex >= m_trailer.frameCount) {
+        return false;
+    }
+    if (!decodeFrame()) {
+        return false;
+    }
+
+    dequantize(frame);
+    frame.radius = m_radius;
+    frame.colour = m_colour;
+    frame.sleeping = m_sleeping;
+    frame.index = m_frameIndex - 1;
+    return true;
+}
+
+// Decode the frame at the cursor into the quantized state
+bool ReplayReader::decodeFrame() {
+    bool ok = false;
+    if (m_offset < m_trailer.indexOffset) {
+        unsigned char type = m_file.data()[m_offset++];
+        if (type == replay::FRAME_KEY) {
+            ok = readKeyframe();
+        }
+        else if (type == replay::FRAME_DELTA) {
+            ok = readDelta();
+        }
+    }
+    if (!ok) {
+        std::cerr << "Replay is damaged at frame " << m_frameIndex << std::endl;
+        m_frameIndex = (size_t)m_trailer.frameCount;
+        m_offset = (size_t)m_trailer.indexOffset;
+        return false;
+    }
+    m_frameIndex++;
+    return true;
+}
+
+// Decode a keyframe
+bool ReplayReader::readKeyframe() {
+    const unsigned char* cursor = m_file.data() + m_offset;
+    const unsigned char* end = m_file.data() + m_trailer.indexOffset;
+
+    int64_t count = 0;
+    if (!replay::readVarint(cursor, end, count) || count < 0 || (uint64_t)count > (uint64_t)(end - cursor) / 8) {
+        return false;
+    }
+
+    m_radius.resize((size_t)count);
+    m_colour.resize((size_t)count);
+    for (size_t i = 0; i < (size_t)count; ++i) {
+        std::memcpy(&m_radius[i], cursor, 4);
+        m_colour[i] = glm::vec4(cursor[4], cursor[5], cursor[6], cursor[7]) / 255.0f;
+        cursor += 8;
+    }
+
+    size_t maskBytes = replay::bitmaskBytes((size_t)count);
+    if ((size_t)(end - cursor) < maskBytes) {
+        return false;
+    }
+    m_sleeping.resize((size_t)count);
+    for (size_t i = 0; i < (size_t)count; ++i) {
+        m_sleeping[i] = (cursor[i / 8] >> (i % 8)) & 1;
+    }
+    cursor += maskBytes;
+
+    for (int c = 0; c < replay::kChannels; ++c) {
+        m_last[c].resize((size_t)count);
+        m_change[c].assign((size_t)count, 0);
+    }
+    for (size_t i = 0; i < (size_t)count; ++i) {
+        for (int c = 0; c < replay::kChannels; ++c) {
+            if (!replay::readVarint(cursor, end, m_last[c][i])) {
+                return false;
+            }
+        }
+    }
+
+    m_offset = cursor - m_file.data();
+    return true;
+}
+
+// Decode a delta frame
+bool ReplayReader::readDelta() {
+    const unsigned char* cursor = m_file.data() + m_offset;
+    const unsigned char* end = m_file.data() + m_trailer.indexOffset;
+    size_t count = m_last[0].size();
+
+    size_t maskBytes = replay::bitmaskBytes(count);
+    if ((size_t)(end - cursor) < maskBytes * 2) {
+        return false;
+    }
+    const unsigned char* sleeping = cursor;
+    const unsigned char* changed = cursor + maskBytes;
+    cursor += maskBytes * 2;
+
+    for (size_t i = 0; i < count; ++i) {
+        m_sleeping[i] = (sleeping[i / 8] >> (i % 8)) & 1;
+        bool ballChanged = (changed[i / 8] >> (i % 8)) & 1;
+        for (int c = 0; c < replay::kChannels; ++c) {
+            int64_t residual = 0;
+            if (ballChanged && !replay::readVarint(cursor, end, residual)) {
+                return false;
+            }
+            int64_t value = m_last[c][i] + m_change[c][i] + residual;
+            m_change[c][i] = value - m_last[c][i];
+            m_last[c][i] = value;
+        }
+    }
+
+    m_offset = cursor - m_file.data();
+    return true;
+}
+
+// Convert the quantized state to floats
+void ReplayReader::dequantize(ReplayFrame& frame) const {
+    std::vector<float>* channels[replay::kChannels] = { &frame.x, &frame.y, &frame.vx, &frame.vy };
+    float quanta[replay::kChannels] = { m_header.positionQuantum, m_header.positionQuantum,
+        m_header.velocityQuantum, m_header.velocityQuantum };
+
+    for (int c = 0; c < replay::kChannels; ++c) {
+        std::vector<float>& values = *channels[c];
+        values.resize(m_last[c].size());
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = (float)((double)m_last[c][i] * quanta[c]);
+        }
+    }
+}
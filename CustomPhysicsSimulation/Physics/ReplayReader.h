@@ -0,0 +1,81 @@
+#pragma once
+#include "glm/vec4.hpp"
+#include "ReplayFormat.h"
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+// State of every ball at one frame of a replay, decoded back to floats (to within half a quantum)
+struct ReplayFrame {
+    std::vector<float> x;         // Position x of each ball
+    std::vector<float> y;         // Position y of each ball
+    std::vector<float> vx;        // Velocity x of each ball
+    std::vector<float> vy;        // Velocity y of each ball
+    std::vector<float> radius;    // Radius of each ball
+    std::vector<glm::vec4> colour; // Colour of each ball
+    std::vector<unsigned char> sleeping; // Sleep flag of each ball
+    size_t index;                 // Frame number, counting from 0 at the start of the recording
+
+    // Gets the number of balls in the frame
+    size_t size() const { return x.size(); }
+};
+
+// Plays back a replay recorded by ReplayWriter. The file is memory mapped and never parsed as a whole: open only
+// checks the header and the footer, and seek finds the nearest keyframe at or before the target in the footer
+// index with a binary search, then decodes just the deltas from there. Memory use depends on the ball count,
+// not on the length of the recording.
+class ReplayReader
+{
+public:
+    ReplayReader();
+
+    // Maps a replay; returns false if the file cannot be read, is not a replay, was never closed (has no index), or
+    // holds no frames, so an open replay always has at least one frame
+    bool open(const std::string& path);
+    // Unmaps the replay
+    void close();
+    // Gets whether a replay is open
+    bool isOpen() const { return m_file.data() != nullptr; }
+
+    // Decodes the next frame into frame (reusing its storage); returns false at the end of the replay or if the
+    // data is damaged
+    bool readFrame(ReplayFrame& frame);
+    // Moves to a frame, so the next readFrame returns it (frames past the end clamp to the last); returns false if
+    // the data is damaged
+    bool seek(size_t frameIndex);
+    // Moves to the frame recorded at a time (in seconds from the start of the recording)
+    bool seekTime(float seconds);
+    // Goes back to the first frame
+    bool rewind() { return seek(0); }
+
+    // Gets the fixed step between frames, in seconds
+    float getTimeStep() const { return m_header.timeStep; }
+    // Gets the number of frames in the replay
+    size_t getFrameCount() const { return (size_t)m_trailer.frameCount; }
+    // Gets the length of the replay, in seconds
+    float getDuration() const { return m_trailer.frameCount * m_header.timeStep; }
+    // Gets the number of the frame the next readFrame returns
+    size_t getFrameIndex() const { return m_frameIndex; }
+
+private:
+    // Decodes the frame at the cursor into the quantized state, without converting it to floats
+    bool decodeFrame();
+    // Decodes a keyframe at the cursor
+    bool readKeyframe();
+    // Decodes a delta frame at the cursor
+    bool readDelta();
+    // Converts the quantized state to the frame's floats
+    void dequantize(ReplayFrame& frame) const;
+
+    MappedFile m_file; // Mapped replay
+    replay::FileHeader m_header; // Header of the file
+    replay::FileTrailer m_trailer; // Trailer of the file, locating the index
+    size_t m_offset; // Offset of the next frame in the file
+    size_t m_frameIndex; // Number of the next frame
+
+    std::vector<float> m_radius; // Radius of each ball, from the last keyframe
+    std::vector<glm::vec4> m_colour; // Colour of each ball, from the last keyframe
+    std::vector<unsigned char> m_sleeping; // Sleep flag of each ball at the last decoded frame
+    std::vector<int64_t> m_last[replay::kChannels]; // Quantized values of each ball at the last decoded frame
+    std::vector<int64_t> m_change[replay::kChannels]; // Change of each value between the last two decoded frames
+};
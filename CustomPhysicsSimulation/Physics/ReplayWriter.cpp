@@ -0,0 +1,317 @@
+#include "ReplayWriter.h"
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+namespace {
+
+// Size of a block of raw frames handed to the encoder
+const size_t kBlockSize = 1 << 16;
+// Encoded frames are written out once this many bytes have built up
+const size_t kFlushSize = 1 << 16;
+
+// Convert a colour channel (0 to 1) to a byte
+unsigned char colourByte(float channel) {
+    return (unsigned char)std::lround(std::min(std::max(channel, 0.0f), 1.0f) * 255.0f);
+}
+
+// Append raw bytes to a buffer
+void append(std::vector<unsigned char>& block, const void* data, size_t size) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    block.insert(block.end(), bytes, bytes + size);
+}
+
+}
+
+// Constructor for ReplayWriter
+ReplayWriter::ReplayWriter() : m_keyframeInterval(600), m_positionQuantum(1.0f / 1024.0f),
+    m_velocityQuantum(1.0f / 256.0f), m_open(false), m_frameCount(0), m_closing(false), m_byteCount(0), m_encodedFrames(0), m_writtenBytes(0),
+    m_fileKeyframeInterval(1) {
+}
+
+// Destructor for ReplayWriter
+ReplayWriter::~ReplayWriter() {
+    close();
+}
+
+// Start a replay of the scene
+bool ReplayWriter::open(const std::string& path, const PhysicsScene& scene) {
+    close();
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open()) {
+        std::cerr << "Failed to create replay " << path << std::endl;
+        return false;
+    }
+
+    replay::FileHeader header;
+    std::memcpy(header.magic, replay::kMagic, 4);
+    header.version = replay::kVersion;
+    header.timeStep = scene.getTimeStep();
+    header.positionQuantum = m_positionQuantum;
+    header.velocityQuantum = m_velocityQuantum;
+    header.keyframeInterval = std::max(m_keyframeInterval, 1u);
+    m_fileKeyframeInterval = header.keyframeInterval;
+
+    m_encoded.clear();
+    replay::writeHeader(m_encoded, header);
+    m_byteCount = m_encoded.size();
+    m_encodedFrames = 0;
+    m_writtenBytes = 0;
+    m_keyframes.clear();
+    m_scales[0] = m_scales[1] = 1.0f / m_positionQuantum;
+    m_scales[2] = m_scales[3] = 1.0f / m_velocityQuantum;
+
+    m_block.size = 0;
+    if (!m_block.data) {
+        m_block.data.reset(new unsigned char[kBlockSize]);
+        m_block.capacity = kBlockSize;
+    }
+    m_lastHandles.clear();
+    m_frameCount = 0;
+    m_closing = false;
+    m_open = true;
+    m_encoder = std::thread(&ReplayWriter::run, this);
+    return true;
+}
+
+// Append a frame holding the current state of the scene
+void ReplayWriter::record(const PhysicsScene& scene) {
+    if (!m_open) {
+        return;
+    }
+
+    // A raw frame is the ball count, then (only when balls were added or removed, which shifts the slots and needs
+    // a keyframe) each ball's radius and colour, then the ball arrays as they are
+    const BallArrays& balls = scene.getBalls();
+    uint32_t count = (uint32_t)balls.size();
+    unsigned char ballsChanged = count != m_lastHandles.size() ||
+        (count > 0 && std::memcmp(balls.handles.data(), m_lastHandles.data(), count * sizeof(Sphere*)) != 0);
+    size_t frameSize = sizeof(count) + 1 + count * (4 * sizeof(float) + 1) +
+        (ballsChanged ? count * (sizeof(float) + sizeof(uint32_t)) : 0);
+    if (m_block.size + frameSize > m_block.capacity) {
+        submitBlock(frameSize);
+    }
+
+    unsigned char* out = m_block.data.get() + m_block.size;
+    std::memcpy(out, &count, sizeof(count));
+    out[sizeof(count)] = ballsChanged;
+    out += sizeof(count) + 1;
+    if (ballsChanged) {
+        m_lastHandles = balls.handles;
+        std::memcpy(out, balls.radius.data(), count * sizeof(float));
+        out += count * sizeof(float);
+        for (Sphere* ball : balls.handles) {
+            glm::vec4 colour = ball->getColour();
+            *out++ = colourByte(colour.r);
+            *out++ = colourByte(colour.g);
+            *out++ = colourByte(colour.b);
+            *out++ = colourByte(colour.a);
+        }
+    }
+    std::memcpy(out, balls.x.data(), count * sizeof(float));
+    out += count * sizeof(float);
+    std::memcpy(out, balls.y.data(), count * sizeof(float));
+    out += count * sizeof(float);
+    std::memcpy(out, balls.vx.data(), count * sizeof(float));
+    out += count * sizeof(float);
+    std::memcpy(out, balls.vy.data(), count * sizeof(float));
+    out += count * sizeof(float);
+    std::memcpy(out, balls.sleeping.data(), count);
+    m_block.size += frameSize;
+    m_frameCount++;
+}
+
+// Hand the current block to the encoder
+void ReplayWriter::submitBlock(size_t minCapacity) {
+    RawBlock next;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_block.size > 0) {
+            m_fullBlocks.push_back(std::move(m_block));
+        }
+        if (!m_freeBlocks.empty()) {
+            next = std::move(m_freeBlocks.back());
+            m_freeBlocks.pop_back();
+        }
+    }
+    m_wake.notify_one();
+
+    // Blocks are only ever replaced by bigger ones, for tables whose single frame outgrows the usual size
+    size_t capacity = std::max(kBlockSize, minCapacity);
+    if (!next.data || next.capacity < capacity) {
+        next.data.reset(new unsigned char[capacity]);
+        next.capacity = capacity;
+    }
+    next.size = 0;
+    m_block = std::move(next);
+}
+
+// Wait for every frame to be written and close the file
+void ReplayWriter::close() {
+    if (!m_open) {
+        return;
+    }
+    m_open = false;
+    submitBlock(0);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closing = true;
+    }
+    m_wake.notify_one();
+    m_encoder.join();
+    m_file.close();
+}
+
+// Encoder thread loop
+void ReplayWriter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [this] { return m_closing || !m_fullBlocks.empty(); });
+        if (m_fullBlocks.empty()) {
+            break;
+        }
+        RawBlock block = std::move(m_fullBlocks.front());
+        m_fullBlocks.pop_front();
+        lock.unlock();
+
+        encodeBlock(block);
+        if (m_encoded.size() >= kFlushSize) {
+            flushEncoded();
+        }
+
+        lock.lock();
+        m_freeBlocks.push_back(std::move(block));
+    }
+    lock.unlock();
+
+    // The frames end where the index starts
+    replay::FileTrailer trailer;
+    trailer.frameCount = m_encodedFrames;
+    trailer.indexOffset = m_writtenBytes + m_encoded.size();
+    trailer.keyframeCount = m_keyframes.size();
+    std::memcpy(trailer.magic, replay::kTrailerMagic, 4);
+    for (const replay::KeyframeEntry& entry : m_keyframes) {
+        replay::writeKeyframeEntry(m_encoded, entry);
+    }
+    replay::writeTrailer(m_encoded, trailer);
+    flushEncoded();
+}
+
+// Write the encoded frames out to the file
+void ReplayWriter::flushEncoded() {
+    m_file.write((const char*)m_encoded.data(), (std::streamsize)m_encoded.size());
+    m_writtenBytes += m_encoded.size();
+    m_encoded.clear();
+}
+
+// Encode every raw frame of a block
+void ReplayWriter::encodeBlock(const RawBlock& block) {
+    const unsigned char* cursor = block.data.get();
+    const unsigned char* end = cursor + block.size;
+    size_t startSize = m_encoded.size();
+
+    while (cursor < end) {
+        uint32_t count;
+        std::memcpy(&count, cursor, sizeof(count));
+        bool ballsChanged = cursor[sizeof(count)] != 0;
+        cursor += sizeof(count) + 1;
+        if (ballsChanged) {
+            m_radius.resize(count);
+            m_colour.resize(count);
+            std::memcpy(m_radius.data(), cursor, count * sizeof(float));
+            std::memcpy(m_colour.data(), cursor + count * sizeof(float), count * sizeof(uint32_t));
+            cursor += count * (sizeof(float) + sizeof(uint32_t));
+        }
+
+        // Round half away from zero, as llround would, without a library call per value
+        for (int c = 0; c < replay::kChannels; ++c) {
+            std::vector<int64_t>& current = m_current[c];
+            current.resize(count);
+            for (uint32_t i = 0; i < count; ++i) {
+                float value;
+                std::memcpy(&value, cursor + i * sizeof(float), sizeof(float));
+                float scaled = value * m_scales[c];
+                current[i] = (int64_t)(scaled + std::copysign(0.5f, scaled));
+            }
+            cursor += count * sizeof(float);
+        }
+        const unsigned char* sleeping = cursor;
+        cursor += count;
+
+        if (ballsChanged || m_encodedFrames % m_fileKeyframeInterval == 0) {
+            writeKeyframe(count, sleeping);
+        }
+        else {
+            writeDelta(count, sleeping);
+        }
+        m_encodedFrames++;
+    }
+
+    m_byteCount += m_encoded.size() - startSize;
+}
+
+// Append a sleeping bitmask
+void ReplayWriter::writeSleeping(size_t count, const unsigned char* sleeping) {
+    size_t start = m_encoded.size();
+    m_encoded.resize(start + replay::bitmaskBytes(count), 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (sleeping[i]) {
+            m_encoded[start + i / 8] |= (unsigned char)(1 << (i % 8));
+        }
+    }
+}
+
+// Append a keyframe
+void ReplayWriter::writeKeyframe(size_t count, const unsigned char* sleeping) {
+    m_keyframes.push_back({ m_encodedFrames, m_writtenBytes + m_encoded.size() });
+    m_encoded.push_back(replay::FRAME_KEY);
+    replay::writeVarint(m_encoded, (int64_t)count);
+
+    // Radius and colour never change, so they are only stored here
+    for (size_t i = 0; i < count; ++i) {
+        append(m_encoded, &m_radius[i], sizeof(float));
+        append(m_encoded, &m_colour[i], sizeof(uint32_t));
+    }
+    writeSleeping(count, sleeping);
+
+    for (size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < replay::kChannels; ++c) {
+            replay::writeVarint(m_encoded, m_current[c][i]);
+        }
+    }
+
+    for (int c = 0; c < replay::kChannels; ++c) {
+        m_last[c] = m_current[c];
+        m_change[c].assign(count, 0);
+    }
+}
+
+// Append a delta frame
+void ReplayWriter::writeDelta(size_t count, const unsigned char* sleeping) {
+    m_encoded.push_back(replay::FRAME_DELTA);
+    writeSleeping(count, sleeping);
+
+    // The changed bitmask is filled in as the residuals are written after it
+    size_t changedStart = m_encoded.size();
+    m_encoded.resize(changedStart + replay::bitmaskBytes(count), 0);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t residual[replay::kChannels];
+        bool changed = false;
+        for (int c = 0; c < replay::kChannels; ++c) {
+            int64_t predicted = m_last[c][i] + m_change[c][i];
+            residual[c] = m_current[c][i] - predicted;
+            changed |= residual[c] != 0;
+
+            m_change[c][i] = m_current[c][i] - m_last[c][i];
+            m_last[c][i] = m_current[c][i];
+        }
+        if (changed) {
+            m_encoded[changedStart + i / 8] |= (unsigned char)(1 << (i % 8));
+            for (int c = 0; c < replay::kChannels; ++c) {
+                replay::writeVarint(m_encoded, residual[c]);
+            }
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "ReplayFormat.h"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <memory>
+
+class PhysicsScene;
+class Sphere;
+
+// Records a scene to a compact binary replay, one frame per fixed step (see ReplayFormat.h for the layout).
+// Attach it with PhysicsScene::setReplayWriter and every step is recorded. A step only copies the ball arrays
+// into a block of raw frames; full blocks are handed to a background thread that quantizes, encodes and writes
+// them, so recording adds a plain array copy to the step no matter how the frames compress.
+class ReplayWriter
+{
+public:
+    ReplayWriter();
+    ~ReplayWriter();
+
+    ReplayWriter(const ReplayWriter&) = delete;
+    ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+    // Sets the frames between keyframes (more keyframes make seeking faster and files larger); used by the next open
+    void setKeyframeInterval(unsigned int interval) { m_keyframeInterval = interval; }
+    // Sets the size of one position unit; used by the next open
+    void setPositionQuantum(float quantum) { m_positionQuantum = quantum; }
+    // Sets the size of one velocity unit; used by the next open
+    void setVelocityQuantum(float quantum) { m_velocityQuantum = quantum; }
+
+    // Starts a replay of the scene at path, replacing any file there; returns false if it cannot be created
+    bool open(const std::string& path, const PhysicsScene& scene);
+    // Appends a frame holding the current state of the scene
+    void record(const PhysicsScene& scene);
+    // Waits for every recorded frame to be encoded and written, writes the keyframe index, and closes the file
+    void close();
+    // Gets whether a replay is being recorded
+    bool isOpen() const { return m_open; }
+
+    // Gets the number of frames recorded since open
+    size_t getFrameCount() const { return m_frameCount; }
+    // Gets the number of bytes encoded so far (frames still waiting for the encoder are not counted)
+    uint64_t getByteCount() const { return m_byteCount; }
+
+private:
+    // Block of raw frames: a plain buffer, so filling it never initialises or grows anything
+    struct RawBlock {
+        std::unique_ptr<unsigned char[]> data; // Raw frames
+        size_t capacity; // Bytes allocated
+        size_t size; // Bytes used
+
+        RawBlock() : capacity(0), size(0) {}
+    };
+
+    // Hands the current block of raw frames to the encoder and starts a fresh one with room for at least minCapacity bytes
+    void submitBlock(size_t minCapacity);
+    // Encoder thread loop: encodes and writes blocks until the replay is closed, then writes the footer
+    void run();
+    // Encodes every raw frame of a block into m_encoded
+    void encodeBlock(const RawBlock& block);
+    // Writes m_encoded out to the file
+    void flushEncoded();
+    // Appends a keyframe for the raw frame's values, resetting the prediction
+    void writeKeyframe(size_t count, const unsigned char* sleeping);
+    // Appends a delta frame for the raw frame's values against the prediction
+    void writeDelta(size_t count, const unsigned char* sleeping);
+    // Appends a sleeping bitmask from one flag byte per ball
+    void writeSleeping(size_t count, const unsigned char* sleeping);
+
+    std::ofstream m_file; // File being recorded (written only by the encoder while it runs)
+    unsigned int m_keyframeInterval; // Frames between keyframes
+    float m_positionQuantum; // Size of one position unit
+    float m_velocityQuantum; // Size of one velocity unit
+
+    // Recording thread
+    bool m_open; // Whether a replay is being recorded (set only by open and close, so it never touches m_file)
+    RawBlock m_block; // Raw frames not yet handed to the encoder
+    std::vector<Sphere*> m_lastHandles; // Balls of the last recorded frame, to spot added or removed balls
+    size_t m_frameCount; // Frames recorded since open
+
+    // Shared with the encoder (guarded by m_mutex)
+    std::mutex m_mutex; // Guards the block queues and m_closing
+    std::condition_variable m_wake; // Wakes the encoder for a new block or to finish
+    std::deque<RawBlock> m_fullBlocks; // Blocks waiting to be encoded, oldest first
+    std::vector<RawBlock> m_freeBlocks; // Encoded blocks kept for reuse
+    bool m_closing; // Whether the encoder should finish the queue and exit
+    std::atomic<uint64_t> m_byteCount; // Bytes encoded since open
+
+    // Encoder thread
+    std::thread m_encoder; // Thread that encodes and writes blocks
+    std::vector<unsigned char> m_encoded; // Encoded frames not yet written out
+    size_t m_encodedFrames; // Frames encoded since open
+    uint64_t m_writtenBytes; // Bytes written out to the file
+    std::vector<replay::KeyframeEntry> m_keyframes; // Where each keyframe starts, written as the footer index
+    float m_scales[replay::kChannels]; // Quantization scale of each channel (1 / quantum)
+    unsigned int m_fileKeyframeInterval; // Keyframe interval stamped into the header (setKeyframeInterval only affects the next open)
+    std::vector<float> m_radius; // Radius of each ball, from the last raw frame that carried them
+    std::vector<uint32_t> m_colour; // RGBA8 colour of each ball, from the last raw frame that carried them
+    std::vector<int64_t> m_current[replay::kChannels]; // Quantized x, y, vx, vy of each ball this frame
+    std::vector<int64_t> m_last[replay::kChannels]; // Quantized values of each ball last frame
+    std::vector<int64_t> m_change[replay::kChannels]; // Change of each value between the last two frames
+};
@@ -1,4 +1,4 @@
-#include "Rigidbody.h"
+#include "RigidBody.h"
 #include <iostream>
 #include <glm/detail/func_geometric.hpp>
 
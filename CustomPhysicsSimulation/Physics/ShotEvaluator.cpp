@@ -0,0 +1,195 @@
+#include "ShotEvaluator.h"
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+
+// Check the quiet condition over a run of balls
+bool RolloutStop::isQuiet(const BallArrays& balls, size_t first, size_t stride, size_t count, const std::vector<Pocket>& pockets) const {
+    if (quietSpeed <= 0.0f) {
+        return false;
+    }
+    // Sleeping balls only move again if something hits them, which takes a moving ball
+    for (size_t k = 0, i = first; k < count; ++k, i += stride) {
+        if (balls.sleeping[i]) continue;
+        if (balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i] > quietSpeed * quietSpeed) {
+            return false;
+        }
+        for (const Pocket& pocket : pockets) {
+            float deltaX = balls.x[i] - pocket.position.x;
+            float deltaY = balls.y[i] - pocket.position.y;
+            float reach = pocket.radius + balls.radius[i] + quietDistance;
+            if (deltaX * deltaX + deltaY * deltaY < reach * reach) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Constructor for ShotEvaluator
+ShotEvaluator::ShotEvaluator(unsigned int threadCount) : m_parkSpacing(0.0f), m_cueBall(0), m_maxSteps(6000), m_shotsPerSecond(0.0) {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    m_threadPool.reset(new ThreadPool(threadCount));
+}
+
+// Destructor for ShotEvaluator
+ShotEvaluator::~ShotEvaluator() {
+}
+
+// Get the number of threads shots are spread across
+unsigned int ShotEvaluator::getThreadCount() const {
+    return m_threadPool->getThreadCount();
+}
+
+// Take a snapshot of the scene to play every shot from
+void ShotEvaluator::setTable(const PhysicsScene& scene) {
+    m_table.reset(new PhysicsScene());
+    copyTable(scene, *m_table);
+    m_table->saveSnapshot(m_snapshot);
+
+    float maxRadius = 0.0f;
+    for (float radius : m_snapshot.radius) {
+        maxRadius = std::max(maxRadius, radius);
+    }
+    m_parkSpacing = maxRadius * 4.0f;
+
+    // Copies of the old table no longer match the snapshot
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+    m_idleScenes.clear();
+}
+
+// Copy the balls, planes, pockets and settings of one scene into another, empty one
+void ShotEvaluator::copyTable(const PhysicsScene& source, PhysicsScene& target) {
+    target.setGravity(source.getGravity());
+    target.setTimeStep(source.getTimeStep());
+    target.setMaxSubsteps(source.getMaxSubsteps());
+    target.setSolver(source.getSolver());
+    target.getEventSolver().setDeceleration(source.getEventSolver().getDeceleration());
+    target.setTableExtents(source.getTableExtents());
+    for (const Pocket& pocket : source.getPockets()) {
+        target.addPocket(pocket.position, pocket.radius);
+    }
+    target.setContinuousCollision(source.getContinuousCollision());
+    target.setBroadphase(source.getBroadphase());
+    target.setNarrowphase(source.getNarrowphase());
+    target.setIntegrator(source.getIntegrator());
+    target.setSleepSpeed(source.getSleepSpeed());
+
+    // Add the actors in their original order so ball slots (and therefore contact order) match the source
+    const BallArrays& balls = source.getBalls();
+    for (PhysicsObject* actor : source.getActors()) {
+        if (actor->getShapeID() == SPHERE) {
+            Sphere* sphere = static_cast<Sphere*>(actor);
+            unsigned int i = sphere->getBallIndex();
+            target.addActor(new Sphere(glm::vec2(balls.x[i], balls.y[i]), glm::vec2(balls.vx[i], balls.vy[i]),
+                sphere->getMass(), balls.radius[i], sphere->getColour()));
+            if (balls.sleeping[i]) {
+                target.sleepBall((unsigned int)(target.getBalls().size() - 1));
+            }
+        }
+        else if (actor->getShapeID() == PLANE) {
+            Plane* plane = static_cast<Plane*>(actor);
+            target.addActor(new Plane(plane->getNormal(), plane->getDistance(), plane->getColour()));
+        }
+    }
+}
+
+// Take an idle copy of the table, building a new one if every copy is in use
+std::unique_ptr<PhysicsScene> ShotEvaluator::acquireScene() const {
+    {
+        std::lock_guard<std::mutex> lock(m_sceneMutex);
+        if (!m_idleScenes.empty()) {
+            std::unique_ptr<PhysicsScene> scene = std::move(m_idleScenes.back());
+            m_idleScenes.pop_back();
+            return scene;
+        }
+    }
+    std::unique_ptr<PhysicsScene> scene(new PhysicsScene());
+    copyTable(*m_table, *scene);
+    return scene;
+}
+
+// Return a copy of the table for reuse by a later shot
+void ShotEvaluator::releaseScene(std::unique_ptr<PhysicsScene> scene) const {
+    std::lock_guard<std::mutex> lock(m_sceneMutex);
+    m_idleScenes.push_back(std::move(scene));
+}
+
+// Move a pocketed ball off the table and put it to sleep
+void ShotEvaluator::parkBall(PhysicsScene& scene, unsigned int index) const {
+    // Parked balls sit in a column well clear of the cushions, one slot apart, so nothing ever reaches them
+    glm::vec2 extents = scene.getTableExtents();
+    scene.getBalls().handles[index]->setPosition(glm::vec2(extents.x * 2.0f + m_parkSpacing, index * m_parkSpacing));
+    scene.sleepBall(index);
+}
+
+// Play a single shot from the snapshot on the calling thread
+ShotOutcome ShotEvaluator::evaluate(const Shot& shot) const {
+    ShotOutcome outcome;
+    outcome.cueBallPosition = glm::vec2(0);
+    outcome.scratch = false;
+    outcome.stepCount = 0;
+    outcome.stoppedEarly = false;
+    if (!m_table || m_cueBall >= m_table->getBalls().size()) {
+        return outcome;
+    }
+
+    std::unique_ptr<PhysicsScene> scene = acquireScene();
+    scene->restoreSnapshot(m_snapshot);
+
+    Sphere* cueBall = scene->getBalls().handles[m_cueBall];
+    cueBall->applyForce(glm::vec2(std::cos(shot.angle), std::sin(shot.angle)) * shot.force);
+
+    while (outcome.stepCount < m_maxSteps && !scene->allBallsStopped()) {
+        scene->step(scene->getTimeStep());
+        outcome.stepCount++;
+
+        bool decided = false;
+        for (Sphere* ball : scene->getPocketedBalls()) {
+            if (ball == cueBall) {
+                outcome.scratch = true;
+                outcome.cueBallPosition = ball->getPosition();
+                decided |= m_stop.cueBallPocketed;
+            }
+            else {
+                outcome.pocketedBalls.push_back(ball->getBallIndex());
+                decided |= (int)ball->getBallIndex() == m_stop.targetBall;
+            }
+            parkBall(*scene, ball->getBallIndex());
+        }
+
+        const BallArrays& balls = scene->getBalls();
+        if (decided || m_stop.isQuiet(balls, 0, 1, balls.size(), scene->getPockets())) {
+            outcome.stoppedEarly = !scene->allBallsStopped();
+            break;
+        }
+    }
+
+    if (!outcome.scratch) {
+        outcome.cueBallPosition = cueBall->getPosition();
+    }
+    releaseScene(std::move(scene));
+    return outcome;
+}
+
+// Play every shot from the snapshot, spread across the pool
+void ShotEvaluator::evaluate(const std::vector<Shot>& shots, std::vector<ShotOutcome>& outcomes) {
+    outcomes.resize(shots.size());
+    auto start = std::chrono::steady_clock::now();
+
+    // Shots vary a lot in length, so hand them out one at a time
+    m_threadPool->parallelFor(shots.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            outcomes[k] = evaluate(shots[k]);
+        }
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_shotsPerSecond = seconds > 0.0 ? shots.size() / seconds : 0.0;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "glm/vec2.hpp"
+#include "PhysicsScene.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+
+class ThreadPool;
+
+// A candidate cue shot: the cue stick angle (radians) and the force applied to the cue ball,
+// matching PhysicsApp's m_cueStickAngle and m_strikeForce
+struct Shot {
+    float angle; // Direction of the shot in radians
+    float force; // Force applied to the cue ball along that direction
+};
+
+// What happened when a shot was played out until every ball came to rest
+struct ShotOutcome {
+    std::vector<unsigned int> pocketedBalls; // Slots (in the table snapshot) of the object balls that dropped, in the order they dropped
+    glm::vec2 cueBallPosition; // Where the cue ball stopped, or where it dropped when scratched
+    bool scratch; // Whether the cue ball dropped into a pocket
+    int stepCount; // Fixed steps simulated before the table came to rest (or the step limit was hit)
+    bool stoppedEarly; // Whether a RolloutStop condition ended the shot before every ball came to rest
+};
+
+// Conditions that end a shot as soon as the part of its outcome the caller cares about is decided,
+// instead of waiting for every ball to roll to rest. Each is checked after every fixed step; all are off by default.
+// A shot that stops early reports the cue ball where it was at that moment.
+struct RolloutStop {
+    int targetBall;       // Stop once the ball in this slot drops into a pocket (-1 to ignore)
+    bool cueBallPocketed; // Stop once the cue ball drops into a pocket
+    float quietSpeed;     // Stop once no moving ball is faster than this... (0 to ignore)
+    float quietDistance;  // ...and no moving ball's edge is within this distance of a pocket's edge
+
+    RolloutStop() : targetBall(-1), cueBallPocketed(false), quietSpeed(0.0f), quietDistance(0.0f) {}
+
+    // Checks the quiet condition over count balls of the arrays, starting at entry first and stride entries apart
+    bool isQuiet(const BallArrays& balls, size_t first, size_t stride, size_t count, const std::vector<Pocket>& pockets) const;
+};
+
+// Plays out many candidate shots from the same table in parallel, without touching the live scene.
+// setTable copies the scene's balls, planes, pockets and settings into a template table. Each thread builds its own
+// copy of that table once, and every shot starts by restoring the copy from a snapshot, so the outcome of a shot
+// does not depend on which thread ran it or what ran before it.
+class ShotEvaluator
+{
+public:
+    // Creates an evaluator that plays shots on threadCount threads (including the caller); 0 uses every hardware thread
+    explicit ShotEvaluator(unsigned int threadCount = 0);
+    ~ShotEvaluator();
+
+    ShotEvaluator(const ShotEvaluator&) = delete;
+    ShotEvaluator& operator=(const ShotEvaluator&) = delete;
+
+    // Takes a snapshot of the scene to play every shot from
+    void setTable(const PhysicsScene& scene);
+
+    // Sets the slot of the cue ball in the snapshot (the app adds the cue ball first, so this defaults to 0)
+    void setCueBall(unsigned int index) { m_cueBall = index; }
+    // Gets the slot of the cue ball in the snapshot
+    unsigned int getCueBall() const { return m_cueBall; }
+
+    // Sets the most fixed steps a shot may run before it is cut off
+    void setMaxSteps(int maxSteps) { m_maxSteps = maxSteps; }
+    // Gets the most fixed steps a shot may run
+    int getMaxSteps() const { return m_maxSteps; }
+
+    // Sets the conditions that end a shot before every ball has stopped
+    void setStopConditions(const RolloutStop& stop) { m_stop = stop; }
+    // Gets the conditions that end a shot before every ball has stopped
+    const RolloutStop& getStopConditions() const { return m_stop; }
+
+    // Plays every shot from the snapshot and writes outcomes[k] for shots[k]
+    void evaluate(const std::vector<Shot>& shots, std::vector<ShotOutcome>& outcomes);
+    // Plays a single shot from the snapshot on the calling thread
+    ShotOutcome evaluate(const Shot& shot) const;
+
+    // Gets the number of threads shots are spread across (including the caller)
+    unsigned int getThreadCount() const;
+    // Gets the throughput of the last batch, in shots per second of wall-clock time
+    double getShotsPerSecond() const { return m_shotsPerSecond; }
+
+private:
+    // Copies the balls, planes, pockets and settings of one scene into another, empty one
+    static void copyTable(const PhysicsScene& source, PhysicsScene& target);
+    // Takes an idle copy of the table, building a new one if every copy is in use
+    std::unique_ptr<PhysicsScene> acquireScene() const;
+    // Returns a copy of the table for reuse by a later shot
+    void releaseScene(std::unique_ptr<PhysicsScene> scene) const;
+    // Moves a pocketed ball off the table and puts it to sleep. The ball keeps its slot, so the table can be put back
+    // by restoring the snapshot rather than re-adding balls.
+    void parkBall(PhysicsScene& scene, unsigned int index) const;
+
+    std::unique_ptr<PhysicsScene> m_table; // Table every copy is built from (never stepped)
+    SceneSnapshot m_snapshot; // State of the table that every shot starts from
+    mutable std::vector<std::unique_ptr<PhysicsScene>> m_idleScenes; // Copies of the table not in use by a shot
+    mutable std::mutex m_sceneMutex; // Guards m_idleScenes
+    float m_parkSpacing; // Distance between parked balls, wide enough that they never touch
+    std::unique_ptr<ThreadPool> m_threadPool; // Threads that play the shots
+    unsigned int m_cueBall; // Slot of the cue ball in the snapshot
+    int m_maxSteps; // Most fixed steps a shot may run
+    RolloutStop m_stop; // Conditions that end a shot early
+    double m_shotsPerSecond; // Throughput of the last batch
+};
@@ -0,0 +1,80 @@
+#include "ShotSuccessEstimator.h"
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+// Constructor for ShotSuccessEstimator
+ShotSuccessEstimator::ShotSuccessEstimator(unsigned int threadCount) : m_evaluator(threadCount),
+    m_noise({ 0.005f, 0.05f, 0.1f }), m_scratchFails(true), m_maxSamples(2000), m_batchSize(64),
+    m_targetHalfWidth(0.02), m_z(1.96), m_seed(1) {
+}
+
+// Compute the Wilson score interval of successes out of samples
+void ShotSuccessEstimator::wilsonInterval(int successes, int samples, double& low, double& high) const {
+    if (samples == 0) {
+        low = 0.0;
+        high = 1.0;
+        return;
+    }
+    double n = samples;
+    double p = successes / n;
+    double z2 = m_z * m_z;
+    double centre = (p + z2 / (2.0 * n)) / (1.0 + z2 / n);
+    double halfWidth = m_z * std::sqrt(p * (1.0 - p) / n + z2 / (4.0 * n * n)) / (1.0 + z2 / n);
+    low = std::max(0.0, centre - halfWidth);
+    high = std::min(1.0, centre + halfWidth);
+}
+
+// Estimate the chance that the shot pockets the target ball
+SuccessEstimate ShotSuccessEstimator::estimate(const Shot& shot, unsigned int targetBall) {
+    std::mt19937 generator(m_seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    // End each sample as soon as its success is settled: a scratch fails it outright, and without the scratch
+    // rule the target dropping succeeds it. The caller's quiet condition is kept, and its settings are put back after.
+    RolloutStop callerStop = m_evaluator.getStopConditions();
+    RolloutStop stop = callerStop;
+    stop.targetBall = m_scratchFails ? -1 : (int)targetBall;
+    stop.cueBallPocketed = m_scratchFails;
+    m_evaluator.setStopConditions(stop);
+
+    SuccessEstimate result;
+    result.samples = 0;
+    result.successes = 0;
+    result.converged = false;
+
+    while (result.samples < m_maxSamples) {
+        int batch = std::min(std::max(m_batchSize, 1), m_maxSamples - result.samples);
+        m_samples.resize(batch);
+        for (Shot& sample : m_samples) {
+            float angle = shot.angle + normal(generator) * m_noise.angleSigma;
+            float force = shot.force * std::max(0.0f, 1.0f + normal(generator) * m_noise.forceSigma);
+
+            // Hitting the cue ball off centre drives it along the normal at the contact point, which turns the
+            // shot by asin(offset) and keeps only the part of the force along that normal (the cue has no spin model)
+            float offset = std::min(std::max(normal(generator) * m_noise.contactSigma, -0.95f), 0.95f);
+            sample.angle = angle + std::asin(offset);
+            sample.force = force * std::sqrt(1.0f - offset * offset);
+        }
+
+        m_evaluator.evaluate(m_samples, m_outcomes);
+        for (const ShotOutcome& outcome : m_outcomes) {
+            bool pocketed = std::find(outcome.pocketedBalls.begin(), outcome.pocketedBalls.end(), targetBall) != outcome.pocketedBalls.end();
+            result.successes += pocketed && !(m_scratchFails && outcome.scratch);
+        }
+        result.samples += batch;
+
+        wilsonInterval(result.successes, result.samples, result.low, result.high);
+        if ((result.high - result.low) * 0.5 <= m_targetHalfWidth) {
+            result.converged = true;
+            break;
+        }
+    }
+
+    if (result.samples == 0) {
+        wilsonInterval(0, 0, result.low, result.high);
+    }
+    result.probability = result.samples > 0 ? (double)result.successes / result.samples : 0.0;
+    m_evaluator.setStopConditions(callerStop);
+    return result;
+}
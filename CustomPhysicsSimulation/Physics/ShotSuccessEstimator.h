@@ -0,0 +1,76 @@
+#pragma once
+#include "ShotEvaluator.h"
+#include <vector>
+
+// Spread of a player's execution of a shot; each sampled shot adds zero-mean normal noise with these deviations
+struct ShotNoise {
+    float angleSigma;   // Deviation of the aim, in radians
+    float forceSigma;   // Deviation of the force, as a fraction of the intended force
+    float contactSigma; // Deviation of the cue tip from the centre of the cue ball, as a fraction of its radius
+};
+
+// Estimated chance that a shot pockets its target, with a confidence interval
+struct SuccessEstimate {
+    double probability; // Fraction of sampled shots that succeeded
+    double low;         // Lower bound of the confidence interval
+    double high;        // Upper bound of the confidence interval
+    int samples;        // Number of shots sampled
+    int successes;      // Number of sampled shots that succeeded
+    bool converged;     // Whether sampling stopped because the interval was tight enough (rather than at the sample limit)
+};
+
+// Monte Carlo estimate of how likely a shot is to succeed when played with some execution noise.
+// Noisy variants of the shot are played in batches on a ShotEvaluator, and sampling stops as soon as the
+// Wilson score interval of the success rate is narrower than the target, or the sample limit is reached.
+// Samples come from a seeded generator on the calling thread, so an estimate does not depend on the thread count.
+class ShotSuccessEstimator
+{
+public:
+    // Creates an estimator that plays samples on threadCount threads (including the caller); 0 uses every hardware thread
+    explicit ShotSuccessEstimator(unsigned int threadCount = 0);
+
+    // Takes a snapshot of the scene to play every sample from
+    void setTable(const PhysicsScene& scene) { m_evaluator.setTable(scene); }
+    // Sets the slot of the cue ball in the snapshot
+    void setCueBall(unsigned int index) { m_evaluator.setCueBall(index); }
+
+    // Sets the execution noise applied to every sample
+    void setNoise(const ShotNoise& noise) { m_noise = noise; }
+    // Gets the execution noise applied to every sample
+    const ShotNoise& getNoise() const { return m_noise; }
+    // Sets whether a sample that pockets the target but also pockets the cue ball counts as a failure
+    void setScratchFails(bool scratchFails) { m_scratchFails = scratchFails; }
+
+    // Sets the most samples an estimate may take
+    void setMaxSamples(int maxSamples) { m_maxSamples = maxSamples; }
+    // Sets how many samples are played between convergence checks
+    void setBatchSize(int batchSize) { m_batchSize = batchSize; }
+    // Sets the half width of the confidence interval at which sampling stops
+    void setTargetHalfWidth(double halfWidth) { m_targetHalfWidth = halfWidth; }
+    // Sets the normal quantile of the confidence level (1.96 for 95%)
+    void setConfidenceZ(double z) { m_z = z; }
+    // Sets the seed of the noise generator; every estimate restarts from this seed
+    void setSeed(unsigned int seed) { m_seed = seed; }
+
+    // Estimates the chance that the shot pockets the ball in slot targetBall
+    SuccessEstimate estimate(const Shot& shot, unsigned int targetBall);
+
+    // Gets the evaluator that plays the samples, to adjust its step limit or quiet stop condition
+    ShotEvaluator& getEvaluator() { return m_evaluator; }
+
+private:
+    // Computes the Wilson score interval of successes out of samples
+    void wilsonInterval(int successes, int samples, double& low, double& high) const;
+
+    ShotEvaluator m_evaluator; // Plays the sampled shots
+    ShotNoise m_noise; // Execution noise applied to every sample
+    bool m_scratchFails; // Whether pocketing the cue ball fails a sample
+    int m_maxSamples; // Most samples an estimate may take
+    int m_batchSize; // Samples played between convergence checks
+    double m_targetHalfWidth; // Interval half width at which sampling stops
+    double m_z; // Normal quantile of the confidence level
+    unsigned int m_seed; // Seed of the noise generator
+
+    std::vector<Shot> m_samples; // Sampled shots of the current batch
+    std::vector<ShotOutcome> m_outcomes; // Outcomes of the current batch
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+// Thin wrapper over the widest float SIMD registers the build targets: AVX2 (8 lanes), SSE2 (4 lanes),
+// or a plain float (1 lane) on anything else. Kernels written against simd::Float run unchanged on all three.
+// Only IEEE-exact operations (add, sub, mul, div, sqrt, compare) are exposed, so a kernel that performs
+// the same operations in the same order as a scalar loop produces bit-identical results.
+// That also needs the scalar loop left unfused, which is why the build pins -ffp-contract=off (/fp:precise);
+// tests/BitIdentityTest.cpp checks it.
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2 1
+#else
+#include <cmath>
+#endif
+
+namespace simd {
+
+#if defined(SIMD_AVX2)
+
+// Number of floats processed per instruction
+const int kWidth = 8;
+// Name of the instruction set in use
+inline const char* name() { return "AVX2"; }
+
+struct Float { __m256 v; };
+struct Mask { __m256 v; };
+
+inline Float broadcast(float f) { return { _mm256_set1_ps(f) }; }
+inline Float load(const float* p) { return { _mm256_loadu_ps(p) }; }
+inline void store(float* p, Float a) { _mm256_storeu_ps(p, a.v); }
+// Loads base[index[lane]] into each lane
+inline Float gather(const float* base, const unsigned int* index) {
+    return { _mm256_i32gather_ps(base, _mm256_loadu_si256((const __m256i*)index), 4) };
+}
+// Loads one byte flag per lane; the lane is set where the flag is non-zero
+inline Mask loadFlags(const unsigned char* flags) {
+    __m256i wide = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)flags));
+    return { _mm256_castsi256_ps(_mm256_cmpgt_epi32(wide, _mm256_setzero_si256())) };
+}
+
+inline Float operator+(Float a, Float b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Float operator-(Float a, Float b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Float operator*(Float a, Float b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Float operator/(Float a, Float b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Float operator-(Float a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+inline Float sqrt(Float a) { return { _mm256_sqrt_ps(a.v) }; }
+
+inline Mask operator<(Float a, Float b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline Mask operator<=(Float a, Float b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline Mask operator>(Float a, Float b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline Mask operator>=(Float a, Float b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline Mask operator==(Float a, Float b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+inline Mask operator&(Mask a, Mask b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline Mask operator|(Mask a, Mask b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline Mask operator~(Mask a) { return { _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))) }; }
+
+// Picks a where the mask is set and b elsewhere
+inline Float select(Mask m, Float a, Float b) { return { _mm256_blendv_ps(b.v, a.v, m.v) }; }
+// Gets one bit per lane, lane 0 in bit 0
+inline int bits(Mask m) { return _mm256_movemask_ps(m.v); }
+
+#elif defined(SIMD_SSE2)
+
+const int kWidth = 4;
+inline const char* name() { return "SSE2"; }
+
+struct Float { __m128 v; };
+struct Mask { __m128 v; };
+
+inline Float broadcast(float f) { return { _mm_set1_ps(f) }; }
+inline Float load(const float* p) { return { _mm_loadu_ps(p) }; }
+inline void store(float* p, Float a) { _mm_storeu_ps(p, a.v); }
+inline Float gather(const float* base, const unsigned int* index) {
+    return { _mm_set_ps(base[index[3]], base[index[2]], base[index[1]], base[index[0]]) };
+}
+inline Mask loadFlags(const unsigned char* flags) {
+    int packed = flags[0] | flags[1] << 8 | flags[2] << 16 | flags[3] << 24;
+    __m128i zero = _mm_setzero_si128();
+    __m128i wide = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+    return { _mm_castsi128_ps(_mm_cmpgt_epi32(wide, zero)) };
+}
+
+inline Float operator+(Float a, Float b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Float operator-(Float a, Float b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Float operator*(Float a, Float b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Float operator/(Float a, Float b) { return { _mm_div_ps(a.v, b.v) }; }
+inline Float operator-(Float a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+inline Float sqrt(Float a) { return { _mm_sqrt_ps(a.v) }; }
+
+inline Mask operator<(Float a, Float b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline Mask operator<=(Float a, Float b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline Mask operator>(Float a, Float b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline Mask operator>=(Float a, Float b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline Mask operator==(Float a, Float b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+inline Mask operator&(Mask a, Mask b) { return { _mm_and_ps(a.v, b.v) }; }
+inline Mask operator|(Mask a, Mask b) { return { _mm_or_ps(a.v, b.v) }; }
+inline Mask operator~(Mask a) { return { _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))) }; }
+
+// SSE2 has no blend instruction, so mix with and/andnot
+inline Float select(Mask m, Float a, Float b) { return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) }; }
+inline int bits(Mask m) { return _mm_movemask_ps(m.v); }
+
+#else
+
+const int kWidth = 1;
+inline const char* name() { return "scalar"; }
+
+struct Float { float v; };
+struct Mask { bool v; };
+
+inline Float broadcast(float f) { return { f }; }
+inline Float load(const float* p) { return { *p }; }
+inline void store(float* p, Float a) { *p = a.v; }
+inline Float gather(const float* base, const unsigned int* index) { return { base[index[0]] }; }
+inline Mask loadFlags(const unsigned char* flags) { return { flags[0] != 0 }; }
+
+inline Float operator+(Float a, Float b) { return { a.v + b.v }; }
+inline Float operator-(Float a, Float b) { return { a.v - b.v }; }
+inline Float operator*(Float a, Float b) { return { a.v * b.v }; }
+inline Float operator/(Float a, Float b) { return { a.v / b.v }; }
+inline Float operator-(Float a) { return { -a.v }; }
+inline Float sqrt(Float a) { return { std::sqrt(a.v) }; }
+
+inline Mask operator<(Float a, Float b) { return { a.v < b.v }; }
+inline Mask operator<=(Float a, Float b) { return { a.v <= b.v }; }
+inline Mask operator>(Float a, Float b) { return { a.v > b.v }; }
+inline Mask operator>=(Float a, Float b) { return { a.v >= b.v }; }
+inline Mask operator==(Float a, Float b) { return { a.v == b.v }; }
+inline Mask operator&(Mask a, Mask b) { return { a.v && b.v }; }
+inline Mask operator|(Mask a, Mask b) { return { a.v || b.v }; }
+inline Mask operator~(Mask a) { return { !a.v }; }
+
+inline Float select(Mask m, Float a, Float b) { return m.v ? a : b; }
+inline int bits(Mask m) { return m.v ? 1 : 0; }
+
+#endif
+
+inline Float& operator+=(Float& a, Float b) { a = a + b; return a; }
+inline Float& operator-=(Float& a, Float b) { a = a - b; return a; }
+inline Float& operator*=(Float& a, Float b) { a = a * b; return a; }
+
+}
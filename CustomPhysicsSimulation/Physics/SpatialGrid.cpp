@@ -0,0 +1,90 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+// Constructor for SpatialGrid
+SpatialGrid::SpatialGrid() : m_cellSize(1.0f), m_bucketMask(0) {
+}
+
+// Hash a cell coordinate into a bucket index (large primes spread neighbouring cells apart)
+unsigned int SpatialGrid::hashCell(int cellX, int cellY) const {
+    unsigned int h = (unsigned int)cellX * 73856093u ^ (unsigned int)cellY * 19349663u;
+    return h & m_bucketMask;
+}
+
+// Rebuild the grid from object centres
+void SpatialGrid::build(const float* x, const float* y, size_t count, float cellSize) {
+    m_cellSize = cellSize > 0.0f ? cellSize : 1.0f;
+    float invCellSize = 1.0f / m_cellSize;
+
+    // Use roughly two buckets per object so most buckets hold a single cell
+    unsigned int bucketCount = 16;
+    while (bucketCount < count * 2) {
+        bucketCount <<= 1;
+    }
+    m_bucketMask = bucketCount - 1;
+
+    m_cellX.resize(count);
+    m_cellY.resize(count);
+    m_bucketStart.assign(bucketCount + 1, 0);
+    m_sortedObjects.resize(count);
+    m_objectBucket.resize(count);
+
+    // Counting sort of the objects by bucket: first count, then prefix sum, then scatter
+    for (size_t i = 0; i < count; ++i) {
+        m_cellX[i] = (int)std::floor(x[i] * invCellSize);
+        m_cellY[i] = (int)std::floor(y[i] * invCellSize);
+        m_objectBucket[i] = hashCell(m_cellX[i], m_cellY[i]);
+        m_bucketStart[m_objectBucket[i] + 1]++;
+    }
+    for (unsigned int b = 0; b < bucketCount; ++b) {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+    m_writeIndex.assign(m_bucketStart.begin(), m_bucketStart.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+        m_sortedObjects[m_writeIndex[m_objectBucket[i]]++] = (unsigned int)i;
+    }
+}
+
+// Find every pair of objects in the same or neighbouring cells
+void SpatialGrid::findPairs(std::vector<CandidatePair>& pairs, const unsigned char* skip) const {
+    unsigned int count = (unsigned int)m_cellX.size();
+    size_t firstOutput = pairs.size();
+
+    for (unsigned int i = 0; i < count; ++i) {
+        // Skipped objects are only found from the other side of a pair
+        if (skip && skip[i]) continue;
+        size_t firstPair = pairs.size();
+
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                int cellX = m_cellX[i] + dx;
+                int cellY = m_cellY[i] + dy;
+                unsigned int bucket = hashCell(cellX, cellY);
+
+                for (unsigned int k = m_bucketStart[bucket]; k < m_bucketStart[bucket + 1]; ++k) {
+                    unsigned int j = m_sortedObjects[k];
+                    // Only accept objects whose real cell is this neighbour, so hash collisions
+                    // between neighbouring cells can never report the same pair twice
+                    if (m_cellX[j] != cellX || m_cellY[j] != cellY) continue;
+                    if (j > i) {
+                        pairs.push_back({ i, j });
+                    }
+                    else if (j < i && skip && skip[j]) {
+                        pairs.push_back({ j, i });
+                    }
+                }
+            }
+        }
+
+        // Keep the brute-force visiting order so both broadphases resolve contacts identically
+        if (!skip) std::sort(pairs.begin() + firstPair, pairs.end(),
+            [](const CandidatePair& p, const CandidatePair& q) { return p.b < q.b; });
+    }
+
+    // Pairs found from their second object are out of order, so restore the brute-force order overall
+    if (skip) {
+        std::sort(pairs.begin() + firstOutput, pairs.end(),
+            [](const CandidatePair& p, const CandidatePair& q) { return p.a != q.a ? p.a < q.a : p.b < q.b; });
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+// A pair of object indices that the broadphase considers close enough to test
+struct CandidatePair {
+    unsigned int a; // Index of the first object (always the smaller index)
+    unsigned int b; // Index of the second object
+};
+
+// Uniform spatial hash used as the broadphase for sphere collisions.
+// Objects are bucketed by the cell their centre falls in, so with a cell size of at least
+// one diameter, any two overlapping spheres are guaranteed to be in the same or adjacent cells.
+class SpatialGrid
+{
+public:
+    SpatialGrid();
+
+    // Rebuilds the grid from object centres, using the given cell size
+    void build(const float* x, const float* y, size_t count, float cellSize);
+
+    // Appends every pair of objects in the same or neighbouring cells to pairs.
+    // Pairs are emitted in ascending (a, b) order, the same order a brute-force double loop visits them.
+    // If skip is given, objects with a non-zero entry are only paired with objects that are not skipped.
+    void findPairs(std::vector<CandidatePair>& pairs, const unsigned char* skip = nullptr) const;
+
+    // Gets the cell size used for the last build
+    float getCellSize() const { return m_cellSize; }
+
+private:
+    // Hashes a cell coordinate into a bucket index
+    unsigned int hashCell(int cellX, int cellY) const;
+
+    float m_cellSize; // Width and height of a grid cell
+    unsigned int m_bucketMask; // Bucket count minus one (bucket count is a power of two)
+
+    std::vector<int> m_cellX; // Cell x coordinate of each object
+    std::vector<int> m_cellY; // Cell y coordinate of each object
+    std::vector<unsigned int> m_bucketStart; // Start of each bucket in m_sortedObjects (bucket count + 1 entries)
+    std::vector<unsigned int> m_sortedObjects; // Object indices sorted by bucket
+    std::vector<unsigned int> m_objectBucket; // Bucket of each object (build scratch, kept to reuse its storage)
+    std::vector<unsigned int> m_writeIndex; // Next free slot of each bucket while scattering (build scratch)
+};
@@ -0,0 +1,62 @@
+#include "Sphere.h"
+#include <glm/glm.hpp>
+
+// Constructor for Sphere
+// Initialises the sphere with position, velocity, mass, radius, and colour
+Sphere::Sphere(glm::vec2 position, glm::vec2 velocity, float mass, float radius, glm::vec4 colour)
+    : Rigidbody(SPHERE, position, velocity, 0, mass), m_radius(radius), m_colour(colour),
+    m_scene(nullptr), m_ballIndex(0) {
+}
+
+// Destructor for Sphere
+Sphere::~Sphere() {
+}
+
+// Update function for Sphere
+// Goes through the accessors so a standalone call also works on a sphere owned by a scene
+void Sphere::fixedUpdate(glm::vec2 gravity, float timeStep) {
+    glm::vec2 velocity = getVelocity() + gravity * timeStep;
+    setVelocity(velocity);
+    setPosition(getPosition() + velocity * timeStep);
+}
+
+// Apply a force to the Sphere
+void Sphere::applyForce(glm::vec2 force) {
+    setVelocity(getVelocity() + force / m_mass);
+}
+
+// Setter for the position of the sphere
+void Sphere::setPosition(const glm::vec2& position) {
+    if (m_scene) {
+        m_scene->getBalls().x[m_ballIndex] = position.x;
+        m_scene->getBalls().y[m_ballIndex] = position.y;
+        // Moving a ball by hand is a teleport, so there is nothing to interpolate from
+        m_scene->getBalls().previousX[m_ballIndex] = position.x;
+        m_scene->getBalls().previousY[m_ballIndex] = position.y;
+        m_scene->markBallChanged(m_ballIndex);
+    }
+    else {
+        m_position = position;
+    }
+}
+
+// Setter for the velocity of the sphere
+void Sphere::setVelocity(const glm::vec2& velocity) {
+    if (m_scene) {
+        m_scene->getBalls().vx[m_ballIndex] = velocity.x;
+        m_scene->getBalls().vy[m_ballIndex] = velocity.y;
+        m_scene->markBallChanged(m_ballIndex);
+    }
+    else {
+        m_velocity = velocity;
+    }
+}
+
+// Setter for the mass of the sphere
+void Sphere::setMass(float mass) {
+    m_mass = mass;
+    if (m_scene) {
+        m_scene->getBalls().invMass[m_ballIndex] = 1.0f / mass;
+        m_scene->markBallChanged(m_ballIndex);
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "RigidBody.h"
+#include "glm/vec4.hpp"
+
+// Class representing a sphere in the physics simulation.
+// Once added to a PhysicsScene the sphere is a thin handle: its position, velocity, mass and radius
+// live in the scene's ball arrays, and the accessors below read and write that slot.
+class Sphere : public Rigidbody {
+public:
+    // Constructor to initialise the sphere with position, velocity, mass, radius, and colour
+    Sphere(glm::vec2 position, glm::vec2 velocity,
+        float mass, float radius, glm::vec4 colour);
+    // Destructor
+    ~Sphere();
+
+    // Updates the sphere's physics (the scene integrates its balls directly, so this is only used standalone)
+    virtual void fixedUpdate(glm::vec2 gravity, float timeStep);
+    // Applies a force to the sphere
+    virtual void applyForce(glm::vec2 force);
+
+    // Getter for the position of the sphere
+    virtual glm::vec2 getPosition() {
+        return m_scene ? glm::vec2(m_scene->getBalls().x[m_ballIndex], m_scene->getBalls().y[m_ballIndex]) : m_position;
+    }
+    // Setter for the position of the sphere
+    virtual void setPosition(const glm::vec2& position);
+    // Getter for the velocity of the sphere
+    virtual glm::vec2 getVelocity() {
+        return m_scene ? glm::vec2(m_scene->getBalls().vx[m_ballIndex], m_scene->getBalls().vy[m_ballIndex]) : m_velocity;
+    }
+    // Setter for the velocity of the sphere
+    virtual void setVelocity(const glm::vec2& velocity);
+
+    // Getter for the radius of the sphere
+    float getRadius() { return m_radius; }
+    // Getter for the colour of the sphere
+    glm::vec4 getColour() { return m_colour; }
+
+    // Setter for the mass of the sphere
+    void setMass(float mass);
+
+    // Gets the scene whose ball arrays hold this sphere's state (nullptr when standalone)
+    PhysicsScene* getScene() const { return m_scene; }
+    // Gets the slot of this sphere in its scene's ball arrays
+    unsigned int getBallIndex() const { return m_ballIndex; }
+
+    glm::vec4 m_colour; // Colour of the sphere
+
+protected:
+    float m_radius; // Radius of the sphere
+
+    PhysicsScene* m_scene;     // Scene that owns this sphere's state, or nullptr when standalone
+    unsigned int m_ballIndex;  // Slot in the scene's ball arrays
+
+    friend class PhysicsScene;
+};
@@ -0,0 +1,86 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+// Constructor for ThreadPool
+ThreadPool::ThreadPool(unsigned int threadCount) : m_task(nullptr), m_count(0), m_grain(1), m_next(0),
+    m_generation(0), m_busyWorkers(0), m_stop(false) {
+    for (unsigned int i = 1; i < threadCount; ++i) {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+// Destructor for ThreadPool
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+// Run a loop across every thread and wait for it to finish
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& task) {
+    if (count == 0) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+
+    // Not worth waking anyone for a single chunk
+    if (m_workers.empty() || count <= grain) {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_grain = grain;
+        m_next = 0;
+        m_busyWorkers = (unsigned int)m_workers.size();
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+// Claim and run chunks of the current loop until none are left
+void ThreadPool::runChunks() {
+    for (;;) {
+        size_t begin = m_next.fetch_add(m_grain);
+        if (begin >= m_count) {
+            return;
+        }
+        (*m_task)(begin, std::min(begin + m_grain, m_count));
+    }
+}
+
+// Body of each worker thread
+void ThreadPool::workerLoop() {
+    unsigned int seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seenGeneration; });
+            if (m_stop) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0) {
+            m_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+// Fixed set of worker threads for data-parallel loops.
+// The calling thread always takes part, so a pool of N threads starts N - 1 workers,
+// and a pool of one thread simply runs every loop inline.
+class ThreadPool
+{
+public:
+    // Creates a pool of threadCount threads in total (including the caller); zero is treated as one
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Gets the number of threads that run each loop (including the caller)
+    unsigned int getThreadCount() const { return (unsigned int)m_workers.size() + 1; }
+
+    // Runs task(begin, end) over [0, count) in chunks of grain items spread across every thread, and waits for all of them.
+    // Which thread runs which chunk varies between calls, so tasks must only write to their own items.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& task);
+
+private:
+    // Body of each worker thread
+    void workerLoop();
+    // Claims and runs chunks of the current loop until none are left
+    void runChunks();
+
+    std::vector<std::thread> m_workers; // Worker threads (the caller is not included)
+    std::mutex m_mutex; // Guards the loop hand-off below
+    std::condition_variable m_wake; // Signalled when a loop starts or the pool shuts down
+    std::condition_variable m_done; // Signalled when the last worker finishes a loop
+
+    const std::function<void(size_t, size_t)>* m_task; // Loop body of the current loop
+    size_t m_count; // Item count of the current loop
+    size_t m_grain; // Chunk size of the current loop
+    std::atomic<size_t> m_next; // Next unclaimed item of the current loop
+    unsigned int m_generation; // Bumped for every loop so workers can tell a new one has started
+    unsigned int m_busyWorkers; // Workers still running the current loop
+    bool m_stop; // Set when the pool is shutting down
+};
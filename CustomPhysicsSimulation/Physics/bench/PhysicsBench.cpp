@@ -0,0 +1,178 @@
+// Microbenchmarks for the physics engine. Each mode builds tables of balls and times a fixed step, or part of one.
+//
+//     physics_bench [dispatch|integrator|workers]
+//
+// With no argument every mode runs. Build with optimisations (the default CMAKE_BUILD_TYPE is Release).
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <thread>
+
+namespace {
+
+// Radius of every ball
+const float kBallRadius = 1.5f;
+// Distance between neighbouring balls when a table is laid out
+const float kBallSpacing = 4.0f;
+// Fastest a ball starts moving along either axis
+const float kMaxSpeed = 30.0f;
+
+// Fills a scene with count balls on a square-ish grid that just fits them, moving in random directions.
+// The table grows with the ball count so every size has the same density of balls.
+void buildTable(PhysicsScene& scene, size_t count) {
+    size_t columns = (size_t)std::ceil(std::sqrt((double)count));
+    float halfWidth = columns * kBallSpacing * 0.5f;
+    scene.setTableExtents(glm::vec2(halfWidth, halfWidth));
+    // Keep every ball awake, so each step does the same work
+    scene.setSleepSpeed(0.0f);
+
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> speed(-kMaxSpeed, kMaxSpeed);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec2 position(-halfWidth + (i % columns + 0.5f) * kBallSpacing, -halfWidth + (i / columns + 0.5f) * kBallSpacing);
+        glm::vec2 velocity(speed(random), speed(random));
+        scene.addActor(new Sphere(position, velocity, 1.0f, kBallRadius, glm::vec4(1, 1, 1, 1)));
+    }
+}
+
+// Runs steps fixed steps of scene and returns the mean milliseconds per step
+double timeSteps(PhysicsScene& scene, int steps) {
+    // One untimed step first, so every buffer has been sized
+    scene.step(scene.getTimeStep());
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < steps; ++i) {
+        scene.step(scene.getTimeStep());
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / steps;
+}
+
+// Picks enough steps to time a table of count balls reliably without taking long
+int stepsFor(size_t count) {
+    return count <= 16 ? 20000 : count <= 1000 ? 1000 : 100;
+}
+
+// Table sizes every mode is run at
+const size_t kTableSizes[] = { 16, 1000, 10000 };
+
+// Compares dynamic_cast dispatch of ball pairs against ShapeType dispatch. Both use the scalar narrowphase and
+// integrator, since the SIMD paths never dispatch per pair.
+void benchDispatch() {
+    std::printf("dispatch: ms/step (scalar narrowphase and integrator, uniform grid)\n");
+    std::printf("%8s %12s %12s\n", "balls", "rtti", "shape type");
+    for (size_t count : kTableSizes) {
+        double ms[2];
+        DispatchType dispatches[2] = { RTTI_DISPATCH, SHAPE_TYPE_DISPATCH };
+        for (int d = 0; d < 2; ++d) {
+            PhysicsScene scene;
+            buildTable(scene, count);
+            scene.setNarrowphase(SCALAR_NARROWPHASE);
+            scene.setIntegrator(SCALAR_INTEGRATOR);
+            scene.setDispatch(dispatches[d]);
+            ms[d] = timeSteps(scene, stepsFor(count));
+        }
+        std::printf("%8zu %12.4f %12.4f\n", count, ms[0], ms[1]);
+    }
+}
+
+// Times one run of the integrate and friction/cushion passes alone on scene's count balls and returns balls stepped
+// per second. Friction would decay the velocities into denormals (which are far slower to multiply) within a few
+// thousand passes, so the table is put back to startState every few hundred, outside the timed part.
+double timeIntegrator(PhysicsScene& scene, const SceneSnapshot& startState, size_t count) {
+    const size_t ballSteps = 20000000;
+    const int passesPerRestore = 200;
+    size_t restores = std::max<size_t>(ballSteps / (count * passesPerRestore), 1);
+
+    double seconds = 0.0;
+    for (size_t r = 0; r < restores; ++r) {
+        scene.restoreSnapshot(startState);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < passesPerRestore; ++i) {
+            scene.stepIntegrator(scene.getTimeStep());
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        seconds += elapsed.count();
+    }
+    return restores * passesPerRestore * count / seconds;
+}
+
+// Compares BallIntegrator::integrate and dampAndBounce against PhysicsScene::integrateBalls and applyFrictionAndWalls,
+// as balls stepped per second. Only those passes run, so collisions cannot hide the difference. The two integrators
+// take turns over several runs and the best of each is kept, so a slow patch on the machine cannot favour either.
+void benchIntegrator() {
+    const int runs = 9;
+    std::printf("integrator: balls/second (integrate and friction/cushion passes only)\n");
+    std::printf("%8s %14s %14s %8s\n", "balls", "scalar", "simd", "speedup");
+    for (size_t count : kTableSizes) {
+        PhysicsScene scenes[2];
+        SceneSnapshot startStates[2];
+        IntegratorType integrators[2] = { SCALAR_INTEGRATOR, SIMD_INTEGRATOR };
+        for (int i = 0; i < 2; ++i) {
+            buildTable(scenes[i], count);
+            scenes[i].setIntegrator(integrators[i]);
+            scenes[i].saveSnapshot(startStates[i]);
+        }
+
+        double rate[2] = { 0.0, 0.0 };
+        for (int run = 0; run < runs; ++run) {
+            for (int i = 0; i < 2; ++i) {
+                rate[i] = std::max(rate[i], timeIntegrator(scenes[i], startStates[i], count));
+            }
+        }
+        std::printf("%8zu %14.0f %14.0f %7.2fx\n", count, rate[0], rate[1], rate[1] / rate[0]);
+    }
+}
+
+// Sweeps the narrowphase worker count from one thread up to every hardware thread on a 10k-ball table
+void benchWorkers() {
+    const size_t count = 10000;
+    unsigned int maxWorkers = std::thread::hardware_concurrency();
+    if (maxWorkers == 0) {
+        maxWorkers = 1;
+    }
+    std::printf("workers: ms/step (%zu balls, SIMD narrowphase and integrator)\n", count);
+    std::printf("%8s %12s %8s\n", "workers", "ms/step", "speedup");
+    double single = 0.0;
+    for (unsigned int workers = 1; workers <= maxWorkers; ++workers) {
+        PhysicsScene scene;
+        buildTable(scene, count);
+        scene.setWorkerCount(workers);
+        double ms = timeSteps(scene, stepsFor(count));
+        if (workers == 1) {
+            single = ms;
+        }
+        std::printf("%8u %12.4f %7.2fx\n", workers, ms, single / ms);
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    const char* mode = argc > 1 ? argv[1] : "all";
+    bool all = std::strcmp(mode, "all") == 0;
+    bool ran = false;
+
+    if (all || std::strcmp(mode, "dispatch") == 0) {
+        benchDispatch();
+        ran = true;
+    }
+    if (all || std::strcmp(mode, "integrator") == 0) {
+        benchIntegrator();
+        ran = true;
+    }
+    if (all || std::strcmp(mode, "workers") == 0) {
+        benchWorkers();
+        ran = true;
+    }
+
+    if (!ran) {
+        std::fprintf(stderr, "Unknown mode %s (expected dispatch, integrator, workers or all)\n", mode);
+        return 1;
+    }
+    return 0;
+}
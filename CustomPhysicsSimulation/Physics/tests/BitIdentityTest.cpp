@@ -0,0 +1,93 @@
+// Checks that the SIMD paths stay bit-identical to the scalar reference implementations: the same table is stepped
+// once with each, and the ball arrays must match byte for byte after every step.
+// Exits with a non-zero status on the first mismatch.
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include "Simd.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Balls in the test table
+const size_t kBallCount = 600;
+// Steps each run takes
+const int kSteps = 300;
+
+// Fills a scene with balls packed closely enough that the narrowphase and the cushions see plenty of contacts
+void buildTable(PhysicsScene& scene) {
+    const float radius = 1.5f;
+    const float spacing = 3.4f;
+    size_t columns = (size_t)std::ceil(std::sqrt((double)kBallCount));
+    float halfWidth = columns * spacing * 0.5f;
+    scene.setTableExtents(glm::vec2(halfWidth, halfWidth));
+
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> speed(-40.0f, 40.0f);
+    for (size_t i = 0; i < kBallCount; ++i) {
+        glm::vec2 position(-halfWidth + (i % columns + 0.5f) * spacing, -halfWidth + (i / columns + 0.5f) * spacing);
+        // Leave some balls at rest so sleeping and waking are covered too
+        glm::vec2 velocity = i % 5 == 0 ? glm::vec2(0) : glm::vec2(speed(random), speed(random));
+        scene.addActor(new Sphere(position, velocity, 1.0f + (i % 3) * 0.5f, radius, glm::vec4(1, 1, 1, 1)));
+    }
+}
+
+// Compares one array of two scenes byte for byte
+template <typename T>
+bool sameBytes(const std::vector<T>& a, const std::vector<T>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+// Compares every per-ball array the solver writes
+bool sameBalls(const BallArrays& a, const BallArrays& b) {
+    return sameBytes(a.x, b.x) && sameBytes(a.y, b.y) && sameBytes(a.vx, b.vx) && sameBytes(a.vy, b.vy) &&
+        sameBytes(a.previousX, b.previousX) && sameBytes(a.previousY, b.previousY) && sameBytes(a.sleeping, b.sleeping);
+}
+
+// Switches a scene to the implementation under test
+typedef void (*Configure)(PhysicsScene& scene);
+
+// Steps a reference scene and a candidate scene side by side; returns false at the first step they differ
+bool compareRuns(const char* name, bool continuous, Configure configureReference, Configure configureCandidate) {
+    PhysicsScene reference;
+    PhysicsScene candidate;
+    buildTable(reference);
+    buildTable(candidate);
+    reference.setContinuousCollision(continuous);
+    candidate.setContinuousCollision(continuous);
+    configureReference(reference);
+    configureCandidate(candidate);
+
+    for (int step = 0; step < kSteps; ++step) {
+        reference.step(reference.getTimeStep());
+        candidate.step(candidate.getTimeStep());
+        if (!sameBalls(reference.getBalls(), candidate.getBalls())) {
+            std::printf("FAIL %s (%s collision): ball state differs after step %d\n", name,
+                continuous ? "continuous" : "discrete", step + 1);
+            return false;
+        }
+    }
+    std::printf("ok   %s (%s collision), %d steps\n", name, continuous ? "continuous" : "discrete", kSteps);
+    return true;
+}
+
+}
+
+int main() {
+    std::printf("SIMD width %d (%s)\n", simd::kWidth, simd::name());
+    bool passed = true;
+
+    for (int continuous = 0; continuous < 2; ++continuous) {
+        passed &= compareRuns("SIMD_NARROWPHASE vs SCALAR_NARROWPHASE", continuous != 0,
+            [](PhysicsScene& scene) { scene.setNarrowphase(SCALAR_NARROWPHASE); },
+            [](PhysicsScene& scene) { scene.setNarrowphase(SIMD_NARROWPHASE); });
+        passed &= compareRuns("SIMD_INTEGRATOR vs SCALAR_INTEGRATOR", continuous != 0,
+            [](PhysicsScene& scene) { scene.setIntegrator(SCALAR_INTEGRATOR); },
+            [](PhysicsScene& scene) { scene.setIntegrator(SIMD_INTEGRATOR); });
+    }
+
+    return passed ? 0 : 1;
+}
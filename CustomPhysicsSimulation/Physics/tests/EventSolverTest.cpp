@@ -0,0 +1,87 @@
+// Plays shots into the app's 15-ball rack under the event-driven solver and checks that every frame stays within a
+// bounded number of events and every shot comes to rest. The rack balls touch exactly, which is what drives an
+// exact-contact solver into inelastic collapse (endless contacts a moment apart) if nothing stops it.
+// Exits with a non-zero status if any shot fails.
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace {
+
+// Most events a single frame may process before the test calls it a livelock
+const size_t kMaxFrameEvents = 5000;
+// Frames a shot gets to come to rest (a minute at 60 frames per second)
+const int kMaxFrames = 3600;
+// Frame time the app steps with
+const float kFrameTime = 1.0f / 60.0f;
+
+// Builds the app's table: cue ball, 15 balls racked in a triangle and six pockets (see PhysicsApp::startup)
+void buildRack(PhysicsScene& scene) {
+    const float ballRadius = 4.0f;
+    scene.setGravity(glm::vec2(0, 0));
+    scene.setSolver(EVENT_DRIVEN);
+    scene.addActor(new Sphere(glm::vec2(-50, 0), glm::vec2(0), 8.0f, ballRadius, glm::vec4(1, 1, 1, 1)));
+
+    glm::vec2 startPosition(0, 30);
+    float rowHeight = ballRadius * 2 * 0.866f;
+    for (int row = 0; row < 5; ++row) {
+        for (int col = 0; col <= row; ++col) {
+            glm::vec2 position = startPosition + glm::vec2(col * ballRadius * 2 - row * ballRadius, row * rowHeight);
+            scene.addActor(new Sphere(glm::vec2(position.y, -position.x), glm::vec2(0), 8.0f, ballRadius, glm::vec4(1, 0, 0, 1)));
+        }
+    }
+
+    const glm::vec2 corners[6] = { { -100, -50 }, { 100, -50 }, { -100, 50 }, { 100, 50 }, { 0, -50 }, { 0, 50 } };
+    for (int i = 0; i < 6; ++i) {
+        scene.addPocket(corners[i], i < 4 ? 10.0f : 8.0f);
+    }
+}
+
+// Strikes the cue ball as the app does and plays frames until the table is at rest; returns false on a livelock
+bool playShot(float angle, float force) {
+    PhysicsScene scene;
+    buildRack(scene);
+    scene.getBalls().handles[0]->applyForce(glm::vec2(std::cos(angle), std::sin(angle)) * force);
+
+    size_t mostEvents = 0;
+    for (int frame = 0; frame < kMaxFrames; ++frame) {
+        scene.update(kFrameTime);
+        size_t events = scene.getEventSolver().getEventCount();
+        mostEvents = std::max(mostEvents, events);
+        if (events > kMaxFrameEvents) {
+            std::printf("FAIL angle %.4f force %.1f: %zu events in frame %d\n", angle, force, events, frame);
+            return false;
+        }
+        if (scene.allBallsStopped()) {
+            return true;
+        }
+    }
+    std::printf("FAIL angle %.4f force %.1f: still moving after %d frames (at most %zu events a frame)\n",
+        angle, force, kMaxFrames, mostEvents);
+    return false;
+}
+
+}
+
+int main() {
+    bool passed = true;
+
+    // A break that used to collapse the rack into endless contacts and freeze the game
+    passed &= playShot(-0.8694f, 1875.5f);
+
+    std::mt19937 random(2024);
+    std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+    std::uniform_real_distribution<float> force(200.0f, 6000.0f);
+    int shots = 200;
+    for (int i = 0; i < shots; ++i) {
+        passed &= playShot(angle(random), force(random));
+    }
+
+    if (passed) {
+        std::printf("ok   %d shots came to rest with at most %zu events a frame\n", shots + 1, kMaxFrameEvents);
+    }
+    return passed ? 0 : 1;
+}
@@ -4,8 +4,10 @@
 #include "Input.h"
 #include "Sphere.h"
 #include "Plane.h"
-#include "Rigidbody.h"
+#include "RigidBody.h"
+#include "PhysicsRenderer.h"
 #include <iostream>
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <glm/gtc/matrix_transform.hpp> // For glm::rotate
@@ -14,7 +16,7 @@
 // Constructor & Destructor
 //---------------------------------------------------------------------
 PhysicsApp::PhysicsApp()
-    : m_2dRenderer(nullptr), m_texture(nullptr), m_font(nullptr), m_font2(nullptr), m_physicsScene(nullptr), m_timer(0.0f), m_cueStickStart(glm::vec2(0)), m_cueStickEnd(glm::vec2(0)),
+    : m_2dRenderer(nullptr), m_texture(nullptr), m_font(nullptr), m_font2(nullptr), m_physicsScene(nullptr), m_aimPreview(nullptr), m_previewShot({ 0.0f, 0.0f }), m_previewTableCurrent(false), m_replayWriter(nullptr), m_replayReader(nullptr), m_replayTime(0.0f), m_eventLog(nullptr), m_tableLayer(0), m_timer(0.0f), m_cueStickStart(glm::vec2(0)), m_cueStickEnd(glm::vec2(0)),
     m_initialCueStickStart(glm::vec2(0)), m_initialCueStickEnd(glm::vec2(0)),
     m_isStriking(false), m_hasHitBall(false), m_stickSpeed(100.0f), m_stickThickness(1.8f),
     m_cueStickAngle(0.0f), m_holeRadius(8.0f), m_initialWhiteBallPosition(glm::vec2(0)),m_cueOffset(12.0f), m_stickLength(80.0f),m_strikeCharge(0.0f), m_strikeForce(0.0f), m_maxCharge(1.0f), m_maxForce(6000.0f)      
@@ -57,7 +59,8 @@ bool PhysicsApp::startup() {
     m_stickThickness = 1.8f;
 
     // ----- Initialise Gizmos and Renderer -----
-    aie::Gizmos::create(255U, 255U, 65535U, 65535U);
+    // Starting capacities only; the gizmo lists grow for bigger tables
+    aie::Gizmos::create(255U, 255U, 4096U, 4096U);
 
     m_2dRenderer = new aie::Renderer2D();
     if (!m_2dRenderer) {
@@ -147,49 +150,93 @@ bool PhysicsApp::startup() {
     m_holeRadii.push_back(8.0f);  // Middle-bottom edge
     m_holeRadii.push_back(8.0f);  // Middle-top edge
 
-    return true;
-}
-
-//---------------------------------------------------------------------
-// draw()
-//---------------------------------------------------------------------
-void PhysicsApp::draw() {
-    // Clear the screen to the background colour
-    clearScreen();
+    // Register the pockets with the physics scene, which reports balls that drop into them
+    for (size_t i = 0; i < m_holePositions.size(); i++) {
+        m_physicsScene->addPocket(m_holePositions[i], m_holeRadii[i]);
+    }
 
-    // Begin drawing sprites
-    m_2dRenderer->begin();
+    // ----- Build the Table Layer -----
+    // The cloth, cushions and pockets never change, so they are uploaded once and redrawn from there every frame
+    aie::Gizmos::begin2DLayer();
 
-    // Draw the billiards table cloth texture (dark green)
-    static float aspectRatio = 16 / 9.f;
+    // Billiards table cloth (dark green)
     aie::Gizmos::add2DAABBFilled(
         glm::vec2(0, 0),
         glm::vec2(100, 50),
         glm::vec4(0, 0.5f, 0, 1)
     );
 
-    // Draw table boundaries
+    // Table boundaries
     aie::Gizmos::add2DLine(glm::vec2(-100, -50), glm::vec2(100, -50), glm::vec4(1, 1, 1, 1));
     aie::Gizmos::add2DLine(glm::vec2(-100, 50), glm::vec2(100, 50), glm::vec4(1, 1, 1, 1));
     aie::Gizmos::add2DLine(glm::vec2(-99.9, -50), glm::vec2(-99.9, 50), glm::vec4(1, 1, 1, 1));
     aie::Gizmos::add2DLine(glm::vec2(100, -50), glm::vec2(100, 50), glm::vec4(1, 1, 1, 1));
 
-    // Draw the pockets (holes)
+    // Pockets (holes)
     for (size_t i = 0; i < m_holePositions.size(); i++) {
-        aie::Gizmos::add2DCircle(
+        aie::Gizmos::add2DCircleFilled(
             m_holePositions[i],
             m_holeRadii[i],
-            32,
             glm::vec4(0, 0, 0, 1)
         );
     }
 
-    // Draw all physics objects (balls, etc.)
-    m_physicsScene->draw();
+    m_tableLayer = aie::Gizmos::end2DLayer();
+
+    // ----- Initialise Aim Preview -----
+    m_aimPreview = new AimPreview();
+
+    // ----- Initialise Replay Recording (off until R is pressed) -----
+    m_replayWriter = new ReplayWriter();
+    m_replayReader = new ReplayReader();
+
+    // ----- Initialise Event Logging (off until L is pressed) -----
+    m_eventLog = new EventLog();
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+// draw()
+//---------------------------------------------------------------------
+void PhysicsApp::draw() {
+    // Clear the screen to the background colour
+    clearScreen();
+
+    // Begin drawing sprites
+    m_2dRenderer->begin();
+
+    static float aspectRatio = 16 / 9.f;
+
+    // Draw all physics objects (balls, etc.), or the replay frame while viewing a replay
+    if (m_replayReader->isOpen()) {
+        PhysicsRenderer::drawReplayFrame(m_replayFrame);
+    }
+    else {
+        PhysicsRenderer::drawScene(*m_physicsScene);
+    }
+
+    // Draw the predicted paths under the cue stick: the cue ball in white, with a ghost ball where it makes
+    // contact, and the first ball it hits in that ball's colour
+    if (m_previewTableCurrent && !m_isStriking && !m_replayReader->isOpen() && !m_aimPath.cueBall.empty()) {
+        glm::vec4 cuePathColour(1, 1, 1, 0.6f);
+        for (size_t i = 1; i < m_aimPath.cueBall.size(); i++) {
+            aie::Gizmos::add2DLine(m_aimPath.cueBall[i - 1], m_aimPath.cueBall[i], cuePathColour);
+        }
+        if (m_aimPath.objectBallIndex >= 0) {
+            const BallArrays& balls = m_physicsScene->getBalls();
+            aie::Gizmos::add2DCircleFilled(m_aimPath.contactPosition, balls.radius[0], glm::vec4(1, 1, 1, 0.3f));
+            glm::vec4 objectPathColour = balls.handles[m_aimPath.objectBallIndex]->getColour();
+            objectPathColour.a = 0.6f;
+            for (size_t i = 1; i < m_aimPath.objectBall.size(); i++) {
+                aie::Gizmos::add2DLine(m_aimPath.objectBall[i - 1], m_aimPath.objectBall[i], objectPathColour);
+            }
+        }
+    }
 
     // ---------------------------
     // Draw the cue stick (brown) with white tip on top
-    if (m_physicsScene->allBallsStopped()) {
+    if (m_physicsScene->allBallsStopped() && !m_replayReader->isOpen()) {
         // Compute the stick vector from start to end.
         glm::vec2 stickVector = m_cueStickEnd - m_cueStickStart;
         float stickLength = glm::length(stickVector);
@@ -231,13 +278,22 @@ void PhysicsApp::draw() {
     }
     // ---------------------------
 
-    // Now issue the draw call for all Gizmos
-    aie::Gizmos::draw2D(glm::ortho<float>(-100, 100, -100 / aspectRatio, 100 / aspectRatio, -1.0f, 1.0f));
+    // Now issue the draw calls: the table layer (cloth, cushions and pockets) first, so all other Gizmos sit on top of it
+    glm::mat4 projection = glm::ortho<float>(-100, 100, -100 / aspectRatio, 100 / aspectRatio, -1.0f, 1.0f);
+    aie::Gizmos::draw2DLayer(m_tableLayer, projection);
+    aie::Gizmos::draw2D(projection);
 
     // Draw text info
     m_2dRenderer->drawText(m_font, "Bradley Robertson - Custom Physics Simulation", 210, 690);
     m_2dRenderer->drawText(m_font2, "Controls: A or D to rotate the pool cue. Left click to take a shot (hold for more power)", 480, 10);
     m_2dRenderer->drawText(m_font2, "Press ESC to quit", 20, 10);
+    if (m_replayReader->isOpen()) {
+        m_2dRenderer->drawText(m_font2, "Viewing replay: hold LEFT or RIGHT to scrub, P to return to the game", 20, 30);
+    }
+    else {
+        m_2dRenderer->drawText(m_font2, m_replayWriter->isOpen() ? "Recording replay (R to stop)" : "Press R to record a replay, P to view it", 20, 30);
+        m_2dRenderer->drawText(m_font2, m_eventLog->isOpen() ? "Logging events to events.jsonl (L to stop)" : "Press L to log collisions, cushions and pockets", 20, 50);
+    }
 
     m_2dRenderer->end();
 }
@@ -250,9 +306,15 @@ void PhysicsApp::update(float deltaTime) {
     aie::Input* input = aie::Input::getInstance();
     aie::Gizmos::clear();
 
+    // While a replay is being viewed the game is paused and the replay decides what is drawn
+    if (m_replayReader->isOpen()) {
+        updateReplay(deltaTime);
+        return;
+    }
+
     if (m_physicsScene) {
+        // The scene runs fixed steps internally; the balls are drawn once, interpolated, in draw()
         m_physicsScene->update(deltaTime);
-        m_physicsScene->draw();
     }
     else {
         std::cerr << "m_physicsScene is nullptr." << std::endl;
@@ -268,7 +330,8 @@ void PhysicsApp::update(float deltaTime) {
     }
 
     // Get the current cue ball position and compute the direction vector
-    glm::vec2 cueBallPosition = dynamic_cast<Sphere*>(m_physicsScene->getActors()[0])->getPosition();
+    // The cue ball is the first ball added to the scene
+    glm::vec2 cueBallPosition = m_physicsScene->getBalls().handles[0]->getPosition();
     glm::vec2 direction = glm::vec2(cos(m_cueStickAngle), sin(m_cueStickAngle));
 
     // If not striking and not in post-strike reset, update the cue stick to follow the cue ball
@@ -343,8 +406,8 @@ void PhysicsApp::update(float deltaTime) {
         m_cueStickStart += movement;
         m_cueStickEnd += movement;
 
-        // Retrieve the cue ball (assumed to be the first actor in the scene).
-        Sphere* cueBall = dynamic_cast<Sphere*>(m_physicsScene->getActors()[0]);
+        // Retrieve the cue ball (assumed to be the first ball in the scene).
+        Sphere* cueBall = m_physicsScene->getBalls().handles[0];
         glm::vec2 cueBallPosition = cueBall->getPosition();
         float cueBallRadius = cueBall->getRadius();
 
@@ -373,24 +436,104 @@ void PhysicsApp::update(float deltaTime) {
         }
     }
 
-    // Check for balls entering the pockets
-    for (auto actor : m_physicsScene->getActors()) {
-        Sphere* ball = dynamic_cast<Sphere*>(actor);
-        if (ball && ball->getColour() != glm::vec4(0, 0, 0, 1)) { // Skip black holes
-            for (size_t i = 0; i < m_holePositions.size(); i++) {
-                if (glm::length(ball->getPosition() - m_holePositions[i]) < m_holeRadii[i]) {
-                    if (ball->getColour() == glm::vec4(1, 1, 1, 1)) { // White ball
-                        ball->setPosition(m_initialWhiteBallPosition);
-                        ball->setVelocity(glm::vec2(0));
-                    }
-                    else {
-                        m_physicsScene->removeActor(ball);
-                        delete ball;
-                    }
-                    break;
-                }
-            }
+    // Handle balls the physics scene reported as dropping into a pocket
+    for (Sphere* ball : m_physicsScene->getPocketedBalls()) {
+        if (ball->getColour() == glm::vec4(0, 0, 0, 1)) { // Skip black holes
+            continue;
+        }
+        if (ball->getColour() == glm::vec4(1, 1, 1, 1)) { // White ball
+            ball->setPosition(m_initialWhiteBallPosition);
+            ball->setVelocity(glm::vec2(0));
+        }
+        else {
+            m_physicsScene->removeActor(ball);
+            delete ball;
+        }
+    }
+
+    // Keep the predicted path in step with the aim. The preview predicts on its own thread and only hands back
+    // finished paths, so aiming never waits for it; a new aim cancels the prediction for the old one.
+    if (m_physicsScene->allBallsStopped() && !m_isStriking && !m_hasHitBall) {
+        if (!m_previewTableCurrent) {
+            // The balls have just come to rest (or been put back), so predict from where they are now
+            m_aimPreview->setTable(*m_physicsScene);
+            m_previewTableCurrent = true;
+            m_aimPath = AimPath();
+            m_previewShot.force = -1.0f; // Force a fresh request
+        }
+        // Preview the power being charged, or half power before the player starts charging
+        float charge = m_strikeCharge > 0.0f ? m_strikeCharge / m_maxCharge : 0.5f;
+        Shot shot = { m_cueStickAngle, charge * m_maxForce };
+        if (shot.angle != m_previewShot.angle || shot.force != m_previewShot.force) {
+            m_aimPreview->request(shot);
+            m_previewShot = shot;
+        }
+        m_aimPreview->poll(m_aimPath);
+    }
+    else {
+        m_previewTableCurrent = false;
+    }
+
+    // Start or stop recording a replay of the game with R
+    if (input->wasKeyPressed(aie::INPUT_KEY_R)) {
+        if (m_replayWriter->isOpen()) {
+            m_physicsScene->setReplayWriter(nullptr);
+            m_replayWriter->close();
+        }
+        else if (m_replayWriter->open("./replay.bpr", *m_physicsScene)) {
+            m_physicsScene->setReplayWriter(m_replayWriter);
+        }
+    }
+
+    // Start or stop logging contact events with L
+    if (input->wasKeyPressed(aie::INPUT_KEY_L)) {
+        if (m_eventLog->isOpen()) {
+            m_physicsScene->setEventLog(nullptr);
+            m_eventLog->close();
         }
+        else if (m_eventLog->open("./events.jsonl", EVENT_LOG_JSONL)) {
+            m_physicsScene->setEventLog(m_eventLog);
+        }
+    }
+
+    // View the last recorded replay with P
+    if (input->wasKeyPressed(aie::INPUT_KEY_P) && !m_replayWriter->isOpen() && m_replayReader->open("./replay.bpr")) {
+        m_replayTime = 0.0f;
+        m_replayReader->readFrame(m_replayFrame);
+    }
+
+    // Exit the application when ESC is pressed
+    if (input->isKeyDown(aie::INPUT_KEY_ESCAPE))
+        quit();
+}
+
+//---------------------------------------------------------------------
+// updateReplay()
+//---------------------------------------------------------------------
+void PhysicsApp::updateReplay(float deltaTime) {
+
+    aie::Input* input = aie::Input::getInstance();
+
+    // Return to the game with P
+    if (input->wasKeyPressed(aie::INPUT_KEY_P)) {
+        m_replayReader->close();
+        return;
+    }
+
+    // Play forward in real time, or hold LEFT or RIGHT to scrub at five times that speed
+    float rate = 1.0f;
+    if (input->isKeyDown(aie::INPUT_KEY_LEFT)) {
+        rate = -5.0f;
+    }
+    else if (input->isKeyDown(aie::INPUT_KEY_RIGHT)) {
+        rate = 5.0f;
+    }
+    m_replayTime = glm::clamp(m_replayTime + rate * deltaTime, 0.0f, m_replayReader->getDuration());
+
+    // Seeking only decodes forward from the nearest keyframe, so jumping around never replays the game from the start
+    size_t frame = std::min((size_t)(m_replayTime / m_replayReader->getTimeStep()), m_replayReader->getFrameCount() - 1);
+    if (frame != m_replayFrame.index && m_replayReader->seek(frame)) {
+        m_replayReader->readFrame(m_replayFrame);
     }
 
     // Exit the application when ESC is pressed
@@ -405,5 +548,10 @@ void PhysicsApp::shutdown() {
     delete m_font;
     delete m_texture;
     delete m_2dRenderer;
+    delete m_aimPreview;
     delete m_physicsScene;
+    delete m_replayWriter; // Closing the replay writes out whatever is still buffered
+    delete m_replayReader;
+    delete m_eventLog; // Closing the log writes out whatever is still queued
+    aie::Gizmos::destroy2DLayer(m_tableLayer);
 }
\ No newline at end of file
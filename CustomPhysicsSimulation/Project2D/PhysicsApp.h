@@ -2,6 +2,10 @@
 #include "Application.h"
 #include "Renderer2D.h"
 #include "PhysicsScene.h"
+#include "AimPreview.h"
+#include "ReplayWriter.h"
+#include "ReplayReader.h"
+#include "EventLog.h"
 #include "Gizmos.h"
 #include "glm/ext.hpp"
 #include "Sphere.h"
@@ -26,11 +30,29 @@ public:
     float m_maxForce;       // The maximum force that can be applied to the cue ball
 
 protected:
+    // Plays back the replay instead of the game: plays forward in real time, LEFT and RIGHT scrub, P goes back
+    void updateReplay(float deltaTime);
+
     aie::Renderer2D* m_2dRenderer; // Renderer for 2D graphics
     aie::Font* m_font;             // Font for text rendering
     aie::Font* m_font2;            // Secondary font for text rendering
     PhysicsScene* m_physicsScene;  // Physics scene for simulation
 
+    // Aim preview variables
+    AimPreview* m_aimPreview;          // Predicts the path of the shot being aimed on a background thread
+    AimPath m_aimPath;                 // Newest predicted path of the cue ball and the first ball it hits
+    Shot m_previewShot;                // Shot the preview was last asked for
+    bool m_previewTableCurrent;        // Whether the preview has the table as it now rests
+
+    // Replay variables
+    ReplayWriter* m_replayWriter;      // Records every fixed step of the game while recording is on
+    ReplayReader* m_replayReader;      // Plays back the recorded replay while viewing it
+    ReplayFrame m_replayFrame;         // Frame of the replay being shown
+    float m_replayTime;                // Time of the replay being shown, in seconds
+
+    // Event log variables
+    EventLog* m_eventLog;              // Streams every collision, cushion bounce and pocket to disk while logging is on
+
     // Cue stick variables
     glm::vec2 m_cueStickStart;         // Start position of the cue stick
     glm::vec2 m_cueStickEnd;           // End position of the cue stick
@@ -48,6 +70,9 @@ protected:
     float m_holeRadius;                // Radius of the holes
     std::vector<glm::vec2> m_holePositions; // Positions of the holes
 
+    // Table drawing variables
+    unsigned int m_tableLayer;         // Gizmo layer holding the cloth, cushions and pockets, built once in startup
+
     // Additional member variables
     aie::Texture* m_texture;           // Texture for rendering
     float m_timer;                     // Timer for the application
@@ -0,0 +1,53 @@
+#include "PhysicsRenderer.h"
+#include "PhysicsScene.h"
+#include "Sphere.h"
+#include "Plane.h"
+#include "ReplayReader.h"
+#include "Gizmos.h"
+
+// Draw each actor according to its shape
+void PhysicsRenderer::drawScene(PhysicsScene& scene) {
+    for (PhysicsObject* actor : scene.getActors()) {
+        switch (actor->getShapeID()) {
+        case SPHERE:
+            drawSphere(scene, *static_cast<Sphere*>(actor));
+            break;
+        case PLANE:
+            drawPlane(*static_cast<Plane*>(actor));
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+// Draw each ball of the frame as the live scene draws its spheres
+void PhysicsRenderer::drawReplayFrame(const ReplayFrame& frame) {
+    for (size_t i = 0; i < frame.size(); ++i) {
+        aie::Gizmos::add2DCircleFilled(glm::vec2(frame.x[i], frame.y[i]), frame.radius[i], frame.colour[i]);
+    }
+}
+
+// Uses Gizmos to draw a filled circle (one instanced quad) representing the sphere
+void PhysicsRenderer::drawSphere(const PhysicsScene& scene, Sphere& sphere) {
+    glm::vec2 position = sphere.getScene() == &scene ? scene.getRenderPosition(sphere.getBallIndex()) : sphere.getPosition();
+    aie::Gizmos::add2DCircleFilled(position, sphere.getRadius(), sphere.getColour());
+}
+
+// Draw the plane as a strip that fades away from its surface
+void PhysicsRenderer::drawPlane(const Plane& plane) {
+    float lineSegmentLength = 300.0f; // Length of the line segment representing the plane
+    glm::vec2 normal = plane.getNormal();
+    glm::vec2 centerPoint = normal * plane.getDistance(); // Centre point of the plane
+    glm::vec2 parallel(normal.y, -normal.x); // Vector parallel to the plane
+    glm::vec4 colour = plane.getColour();
+    glm::vec4 colourFade = colour;
+    colourFade.a = 0; // Set alpha to 0 for fading effect
+
+    glm::vec2 start = centerPoint + (parallel * lineSegmentLength); // Start point of the line segment
+    glm::vec2 end = centerPoint - (parallel * lineSegmentLength); // End point of the line segment
+
+    // Draw the plane with fading edges
+    aie::Gizmos::add2DTri(start, end, start - normal * 10.0f, colour, colour, colourFade);
+    aie::Gizmos::add2DTri(end, end - normal * 10.0f, start - normal * 10.0f, colour, colourFade, colourFade);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+class PhysicsScene;
+class Sphere;
+class Plane;
+struct ReplayFrame;
+
+// Draws a PhysicsScene with Gizmos.
+// The physics library has no knowledge of the renderer, so the app routes every frame's scene draw through here.
+class PhysicsRenderer {
+public:
+    // Adds a gizmo for every actor in the scene; balls are drawn at their interpolated render position
+    static void drawScene(PhysicsScene& scene);
+    // Adds a gizmo for every ball in a recorded replay frame
+    static void drawReplayFrame(const ReplayFrame& frame);
+
+private:
+    static void drawSphere(const PhysicsScene& scene, Sphere& sphere);
+    static void drawPlane(const Plane& plane);
+};
@@ -3,27 +3,80 @@
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 namespace aie {
 
 Gizmos* Gizmos::sm_singleton = nullptr;
 
+// compiles and links a gizmo shader program, binding attributes 0 and 1 to the given names
+static unsigned int createShaderProgram(const char* vsSource, const char* fsSource,
+										const char* attribute0, const char* attribute1) {
+	unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
+	unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
+
+	glShaderSource(vs, 1, (const char**)&vsSource, 0);
+	glCompileShader(vs);
+
+	glShaderSource(fs, 1, (const char**)&fsSource, 0);
+	glCompileShader(fs);
+
+	unsigned int program = glCreateProgram();
+	glAttachShader(program, vs);
+	glAttachShader(program, fs);
+	glBindAttribLocation(program, 0, attribute0);
+	glBindAttribLocation(program, 1, attribute1);
+	glLinkProgram(program);
+
+	int success = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (success == GL_FALSE) {
+		int infoLogLength = 0;
+		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &infoLogLength);
+		char* infoLog = new char[infoLogLength + 1];
+
+		glGetProgramInfoLog(program, infoLogLength, 0, infoLog);
+		printf("Error: Failed to link Gizmo shader program!\n%s\n", infoLog);
+		delete[] infoLog;
+	}
+
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+	return program;
+}
+
 Gizmos::Gizmos(unsigned int maxLines, unsigned int maxTris,
-			   unsigned int max2DLines, unsigned int max2DTris)
+			   unsigned int max2DLines, unsigned int max2DTris,
+			   unsigned int max2DCircles)
 	: m_maxLines(maxLines),
 	m_lineCount(0),
-	m_lines(new GizmoLine[maxLines]),
+	m_lines(nullptr),
 	m_maxTris(maxTris),
 	m_triCount(0),
-	m_tris(new GizmoTri[maxTris]),
+	m_tris(nullptr),
+	m_maxTransparentTris(maxTris),
 	m_transparentTriCount(0),
-	m_transparentTris(new GizmoTri[maxTris]),
+	m_transparentTris(nullptr),
 	m_max2DLines(max2DLines),
 	m_2DlineCount(0),
-	m_2Dlines(new GizmoLine[max2DLines]),
+	m_2Dlines(nullptr),
 	m_max2DTris(max2DTris),
 	m_2DtriCount(0),
-	m_2Dtris(new GizmoTri[max2DTris]) {
+	m_2Dtris(nullptr),
+	m_max2DCircles(max2DCircles),
+	m_2DcircleCount(0),
+	m_2Dcircles(nullptr),
+	m_persistent(glBufferStorage != nullptr && glFenceSync != nullptr && glDrawArraysInstancedBaseInstance != nullptr),
+	m_region(0),
+	m_capacityLimit(1 << 20),
+	m_stats(),
+	m_recordingLayer(false),
+	m_layerLineStart(0),
+	m_layerTriStart(0),
+	m_layerCircleStart(0) {
+	for (unsigned int i = 0; i < sm_regionCount; ++i)
+		m_fences[i] = nullptr;
 
 	// create shaders
 	const char* vsSource = "#version 150\n \
@@ -37,127 +90,245 @@ Gizmos::Gizmos(unsigned int maxLines, unsigned int maxTris,
 					 in vec4 vColour; \
                      out vec4 FragColor; \
 					 void main()	{ FragColor = vColour; }";
-    
-    
-	unsigned int vs = glCreateShader(GL_VERTEX_SHADER);
-	unsigned int fs = glCreateShader(GL_FRAGMENT_SHADER);
 
-	glShaderSource(vs, 1, (const char**)&vsSource, 0);
-	glCompileShader(vs);
+	m_shader = createShaderProgram(vsSource, fsSource, "Position", "Colour");
 
-	glShaderSource(fs, 1, (const char**)&fsSource, 0);
-	glCompileShader(fs);
+	// 2D gizmos only store x and y; they are drawn at z = 1 like the 3D shader's 2D input used to be
+	const char* vs2DSource = "#version 150\n \
+					 in vec2 Position; \
+					 in vec4 Colour; \
+					 out vec4 vColour; \
+					 uniform mat4 ProjectionView; \
+					 void main() { vColour = Colour; gl_Position = ProjectionView * vec4(Position, 1, 1); }";
 
-	m_shader = glCreateProgram();
-	glAttachShader(m_shader, vs);
-	glAttachShader(m_shader, fs);
-	glBindAttribLocation(m_shader, 0, "Position");
-	glBindAttribLocation(m_shader, 1, "Colour");
-	glLinkProgram(m_shader);
-    
-	int success = GL_FALSE;
-    glGetProgramiv(m_shader, GL_LINK_STATUS, &success);
-	if (success == GL_FALSE) {
-		int infoLogLength = 0;
-		glGetProgramiv(m_shader, GL_INFO_LOG_LENGTH, &infoLogLength);
-		char* infoLog = new char[infoLogLength + 1];
-        
-		glGetProgramInfoLog(m_shader, infoLogLength, 0, infoLog);
-		printf("Error: Failed to link Gizmo shader program!\n%s\n", infoLog);
-		delete[] infoLog;
-	}
+	m_2Dshader = createShaderProgram(vs2DSource, fsSource, "Position", "Colour");
 
-	glDeleteShader(vs);
-	glDeleteShader(fs);
-    
-    // create VBOs
-	glGenBuffers( 1, &m_lineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxLines * sizeof(GizmoLine), m_lines, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_triVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(GizmoTri), m_tris, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_transparentTriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_maxTris * sizeof(GizmoTri), m_transparentTris, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_2DlineVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DLines * sizeof(GizmoLine), m_2Dlines, GL_DYNAMIC_DRAW);
-
-	glGenBuffers( 1, &m_2DtriVBO );
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
-	glBufferData(GL_ARRAY_BUFFER, m_max2DTris * sizeof(GizmoTri), m_2Dtris, GL_DYNAMIC_DRAW);
-
-	glGenVertexArrays(1, &m_lineVAO);
-	glBindVertexArray(m_lineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_lineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)16);
+	// filled circles expand each instance into a quad from gl_VertexID (drawn as a 4-vertex strip),
+	// then cover the pixels inside the unit circle, fading out over the last pixel of the radius
+	const char* circleVsSource = "#version 150\n \
+					 in vec3 Circle; \
+					 in vec4 Colour; \
+					 out vec4 vColour; \
+					 out vec2 vOffset; \
+					 uniform mat4 ProjectionView; \
+					 void main() { \
+						vOffset = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 2.0 - 1.0; \
+						vColour = Colour; \
+						gl_Position = ProjectionView * vec4(Circle.xy + vOffset * Circle.z, 1, 1); }";
 
-	glGenVertexArrays(1, &m_triVAO);
-	glBindVertexArray(m_triVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_triVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)16);
+	const char* circleFsSource = "#version 150\n \
+					 in vec4 vColour; \
+					 in vec2 vOffset; \
+					 out vec4 FragColor; \
+					 void main() { \
+						float radial = length(vOffset); \
+						float coverage = clamp((1.0 - radial) / fwidth(radial), 0.0, 1.0); \
+						if (coverage <= 0.0) discard; \
+						FragColor = vec4(vColour.rgb, vColour.a * coverage); }";
+
+	m_circleShader = createShaderProgram(circleVsSource, circleFsSource, "Circle", "Colour");
+
+	// create streaming VBOs; the primitive lists point into the first frame's regions
+	createStream(m_lineStream, m_maxLines * sizeof(GizmoLine), VERTEX_LAYOUT);
+	createStream(m_triStream, m_maxTris * sizeof(GizmoTri), VERTEX_LAYOUT);
+	createStream(m_transparentTriStream, m_maxTransparentTris * sizeof(GizmoTri), VERTEX_LAYOUT);
+	createStream(m_2DlineStream, m_max2DLines * sizeof(Gizmo2DLine), VERTEX_2D_LAYOUT);
+	createStream(m_2DtriStream, m_max2DTris * sizeof(Gizmo2DTri), VERTEX_2D_LAYOUT);
+	createStream(m_2DcircleStream, m_max2DCircles * sizeof(GizmoCircle), CIRCLE_LAYOUT);
+	m_region = sm_regionCount - 1;
+	beginFrame();
+}
 
-	glGenVertexArrays(1, &m_transparentTriVAO);
-	glBindVertexArray(m_transparentTriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_transparentTriVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)16);
+Gizmos::~Gizmos() {
+	destroyStream(m_lineStream);
+	destroyStream(m_triStream);
+	destroyStream(m_transparentTriStream);
+	destroyStream(m_2DlineStream);
+	destroyStream(m_2DtriStream);
+	destroyStream(m_2DcircleStream);
+	for (unsigned int i = 0; i < m_layers.size(); ++i)
+		destroy2DLayer(i + 1);
+	glDeleteProgram(m_shader);
+	glDeleteProgram(m_2Dshader);
+	glDeleteProgram(m_circleShader);
+	for (unsigned int i = 0; i < sm_regionCount; ++i) {
+		if (m_fences[i] != nullptr)
+			glDeleteSync((GLsync)m_fences[i]);
+	}
+}
 
-	glGenVertexArrays(1, &m_2DlineVAO);
-	glBindVertexArray(m_2DlineVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DlineVBO);
-	glEnableVertexAttribArray(0);
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)16);
+void Gizmos::createStream(StreamBuffer& stream, size_t regionSize, VertexLayout layout) {
+	stream.layout = layout;
+	stream.regionSize = regionSize;
+	stream.persistent = false;
+	glGenBuffers( 1, &stream.vbo );
+	glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+
+	if (m_persistent) {
+		// immutable storage for every region, mapped once for the life of the buffer. coherent, so writes
+		// reach the GPU without flushing; the fences keep the CPU out of regions the GPU has yet to read
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, regionSize * sm_regionCount, nullptr, flags);
+		stream.memory = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, regionSize * sm_regionCount, flags);
+		if (stream.memory != nullptr)
+			stream.persistent = true;
+		else {
+			// buffer storage is immutable, so start again with a plain buffer
+			printf("Warning: Failed to map Gizmo buffer, falling back to glBufferSubData\n");
+			glDeleteBuffers( 1, &stream.vbo );
+			glGenBuffers( 1, &stream.vbo );
+			glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+		}
+	}
+
+	if (!stream.persistent) {
+		glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_DYNAMIC_DRAW);
+		stream.memory = new unsigned char[regionSize];
+	}
 
-	glGenVertexArrays(1, &m_2DtriVAO);
-	glBindVertexArray(m_2DtriVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, m_2DtriVBO);
+	stream.vao = createVAO(stream.vbo, layout, 0);
+}
+
+unsigned int Gizmos::createVAO(unsigned int vbo, VertexLayout layout, size_t offset) {
+	unsigned int vao;
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
 	glEnableVertexAttribArray(0);
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), 0);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)16);
+	if (layout == CIRCLE_LAYOUT) {
+		// one circle per instance rather than per vertex
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GizmoCircle), (void*)offset);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoCircle), (void*)(offset + 12));
+		glVertexAttribDivisor(0, 1);
+		glVertexAttribDivisor(1, 1);
+	}
+	else if (layout == VERTEX_2D_LAYOUT) {
+		// colours are normalised from 0-255 back to 0-1
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Gizmo2DVertex), (void*)offset);
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Gizmo2DVertex), (void*)(offset + 8));
+	}
+	else {
+		glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)offset);
+		glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoVertex), (void*)(offset + 16));
+	}
 
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	return vao;
 }
 
-Gizmos::~Gizmos() {
-	delete[] m_lines;
-	delete[] m_tris;
-	delete[] m_transparentTris;
-	glDeleteBuffers( 1, &m_lineVBO );
-	glDeleteBuffers( 1, &m_triVBO );
-	glDeleteBuffers( 1, &m_transparentTriVBO );
-	glDeleteVertexArrays( 1, &m_lineVAO );
-	glDeleteVertexArrays( 1, &m_triVAO );
-	glDeleteVertexArrays( 1, &m_transparentTriVAO );
-	delete[] m_2Dlines;
-	delete[] m_2Dtris;
-	glDeleteBuffers( 1, &m_2DlineVBO );
-	glDeleteBuffers( 1, &m_2DtriVBO );
-	glDeleteVertexArrays( 1, &m_2DlineVAO );
-	glDeleteVertexArrays( 1, &m_2DtriVAO );
-	glDeleteProgram(m_shader);
+void Gizmos::destroyStream(StreamBuffer& stream) {
+	if (stream.persistent) {
+		glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	else {
+		delete[] stream.memory;
+	}
+	glDeleteBuffers( 1, &stream.vbo );
+	glDeleteVertexArrays( 1, &stream.vao );
+	stream.memory = nullptr;
+}
+
+bool Gizmos::grow(StreamBuffer& stream, unsigned int& maxPrimitives, unsigned int count, size_t primitiveSize, ListStats& stats) {
+	if (maxPrimitives >= m_capacityLimit) {
+		stats.dropped++;
+		return false;
+	}
+	unsigned int newMax = (unsigned int)std::min<size_t>(std::max<size_t>(maxPrimitives * (size_t)2, 64), m_capacityLimit);
+
+	// the GPU may still be reading earlier frames from the old buffer, but GL keeps a deleted buffer alive until it has
+	StreamBuffer old = stream;
+	createStream(stream, newMax * primitiveSize, old.layout);
+
+	size_t bytes = count * primitiveSize;
+	if (stream.persistent && old.persistent) {
+		// end2DLayer reads the layer being recorded back through the mapping, where a GPU copy still in flight
+		// would not show yet, so that part is copied on the CPU. it was written by the CPU, so it is never stale
+		size_t gpuBytes = bytes;
+		if (m_recordingLayer) {
+			if (&stream == &m_2DlineStream)
+				gpuBytes = m_layerLineStart * primitiveSize;
+			else if (&stream == &m_2DtriStream)
+				gpuBytes = m_layerTriStart * primitiveSize;
+			else if (&stream == &m_2DcircleStream)
+				gpuBytes = m_layerCircleStart * primitiveSize;
+		}
+
+		// copy the rest on the GPU; reading back through the old mapping would be slow, as it is usually write-combined
+		if (gpuBytes > 0) {
+			glBindBuffer(GL_COPY_READ_BUFFER, old.vbo);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, stream.vbo);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+								m_region * old.regionSize, m_region * stream.regionSize, gpuBytes);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		}
+		if (bytes > gpuBytes)
+			memcpy(streamRegion(stream) + gpuBytes, streamRegion(old) + gpuBytes, bytes - gpuBytes);
+	}
+	else if (bytes > 0)
+		memcpy(streamRegion(stream), streamRegion(old), bytes);
+	destroyStream(old);
+
+	maxPrimitives = newMax;
+	pointLists();
+	return true;
+}
+
+unsigned char* Gizmos::streamRegion(const StreamBuffer& stream) const {
+	return stream.persistent ? stream.memory + m_region * stream.regionSize : stream.memory;
+}
+
+size_t Gizmos::uploadStream(const StreamBuffer& stream, size_t bytes, ListStats& stats) {
+	stats.bytesUploaded += bytes;
+	if (stream.persistent)
+		return m_region * stream.regionSize; // already in place
+	glBindBuffer(GL_ARRAY_BUFFER, stream.vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, stream.memory);
+	return 0;
+}
+
+void Gizmos::beginFrame() {
+	m_region = (m_region + 1) % sm_regionCount;
+
+	// the region was last drawn sm_regionCount frames ago, so this rarely has to wait
+	if (m_fences[m_region] != nullptr) {
+		GLsync fence = (GLsync)m_fences[m_region];
+		GLenum result = glClientWaitSync(fence, 0, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		glDeleteSync(fence);
+		m_fences[m_region] = nullptr;
+	}
+
+	pointLists();
+}
+
+void Gizmos::pointLists() {
+	m_lines = (GizmoLine*)streamRegion(m_lineStream);
+	m_tris = (GizmoTri*)streamRegion(m_triStream);
+	m_transparentTris = (GizmoTri*)streamRegion(m_transparentTriStream);
+	m_2Dlines = (Gizmo2DLine*)streamRegion(m_2DlineStream);
+	m_2Dtris = (Gizmo2DTri*)streamRegion(m_2DtriStream);
+	m_2Dcircles = (GizmoCircle*)streamRegion(m_2DcircleStream);
+}
+
+void Gizmos::fenceFrame() {
+	if (!m_persistent)
+		return;
+	// a later fence covers everything before it, so only the newest one per region is kept
+	if (m_fences[m_region] != nullptr)
+		glDeleteSync((GLsync)m_fences[m_region]);
+	m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 }
 
 void Gizmos::create(unsigned int maxLines, unsigned int maxTris,
-					unsigned int max2DLines, unsigned int max2DTris) {
+					unsigned int max2DLines, unsigned int max2DTris,
+					unsigned int max2DCircles) {
 	if (sm_singleton == nullptr)
-		sm_singleton = new Gizmos(maxLines,maxTris,max2DLines,max2DTris);
+		sm_singleton = new Gizmos(maxLines,maxTris,max2DLines,max2DTris,max2DCircles);
 }
 
 void Gizmos::destroy() {
@@ -165,12 +336,138 @@ void Gizmos::destroy() {
 	sm_singleton = nullptr;
 }
 
+// folds a finished frame into a list's stats and starts the next
+static void resetStats(Gizmos::ListStats& stats, unsigned int count) {
+	stats.highWater = std::max(stats.highWater, count);
+	stats.dropped = 0;
+	stats.bytesUploaded = 0;
+}
+
+// fills in the parts of a list's stats that come from the list itself
+static void finishStats(Gizmos::ListStats& stats, unsigned int count, unsigned int capacity) {
+	stats.submitted = count + stats.dropped;
+	stats.highWater = std::max(stats.highWater, count);
+	stats.capacity = capacity;
+}
+
 void Gizmos::clear() {
+	resetStats(sm_singleton->m_stats.lines, sm_singleton->m_lineCount);
+	resetStats(sm_singleton->m_stats.tris, sm_singleton->m_triCount);
+	resetStats(sm_singleton->m_stats.transparentTris, sm_singleton->m_transparentTriCount);
+	resetStats(sm_singleton->m_stats.lines2D, sm_singleton->m_2DlineCount);
+	resetStats(sm_singleton->m_stats.tris2D, sm_singleton->m_2DtriCount);
+	resetStats(sm_singleton->m_stats.circles2D, sm_singleton->m_2DcircleCount);
+
+	sm_singleton->beginFrame();
 	sm_singleton->m_lineCount = 0;
 	sm_singleton->m_triCount = 0;
 	sm_singleton->m_transparentTriCount = 0;
 	sm_singleton->m_2DlineCount = 0;
 	sm_singleton->m_2DtriCount = 0;
+	sm_singleton->m_2DcircleCount = 0;
+}
+
+Gizmos::Stats Gizmos::getStats() {
+	Stats stats = {};
+	if (sm_singleton != nullptr) {
+		stats = sm_singleton->m_stats;
+		finishStats(stats.lines, sm_singleton->m_lineCount, sm_singleton->m_maxLines);
+		finishStats(stats.tris, sm_singleton->m_triCount, sm_singleton->m_maxTris);
+		finishStats(stats.transparentTris, sm_singleton->m_transparentTriCount, sm_singleton->m_maxTransparentTris);
+		finishStats(stats.lines2D, sm_singleton->m_2DlineCount, sm_singleton->m_max2DLines);
+		finishStats(stats.tris2D, sm_singleton->m_2DtriCount, sm_singleton->m_max2DTris);
+		finishStats(stats.circles2D, sm_singleton->m_2DcircleCount, sm_singleton->m_max2DCircles);
+	}
+	return stats;
+}
+
+void Gizmos::setCapacityLimit(unsigned int limit) {
+	if (sm_singleton != nullptr)
+		sm_singleton->m_capacityLimit = limit;
+}
+
+void Gizmos::begin2DLayer() {
+	if (sm_singleton != nullptr) {
+		sm_singleton->m_recordingLayer = true;
+		sm_singleton->m_layerLineStart = sm_singleton->m_2DlineCount;
+		sm_singleton->m_layerTriStart = sm_singleton->m_2DtriCount;
+		sm_singleton->m_layerCircleStart = sm_singleton->m_2DcircleCount;
+	}
+}
+
+unsigned int Gizmos::end2DLayer() {
+	if (sm_singleton == nullptr || !sm_singleton->m_recordingLayer)
+		return 0;
+	sm_singleton->m_recordingLayer = false;
+
+	// the layer's gizmos were added to the end of this frame's lists; move them out into the layer's buffer
+	Layer2D layer = {};
+	layer.lineCount = sm_singleton->m_2DlineCount - sm_singleton->m_layerLineStart;
+	layer.triCount = sm_singleton->m_2DtriCount - sm_singleton->m_layerTriStart;
+	layer.circleCount = sm_singleton->m_2DcircleCount - sm_singleton->m_layerCircleStart;
+	sm_singleton->m_2DlineCount = sm_singleton->m_layerLineStart;
+	sm_singleton->m_2DtriCount = sm_singleton->m_layerTriStart;
+	sm_singleton->m_2DcircleCount = sm_singleton->m_layerCircleStart;
+	if (layer.lineCount == 0 && layer.triCount == 0 && layer.circleCount == 0)
+		return 0;
+
+	size_t lineBytes = layer.lineCount * sizeof(Gizmo2DLine);
+	size_t triBytes = layer.triCount * sizeof(Gizmo2DTri);
+	size_t circleBytes = layer.circleCount * sizeof(GizmoCircle);
+
+	// uploaded straight from the lists; slow if they are mapped, but it only happens once per layer
+	glGenBuffers(1, &layer.vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, layer.vbo);
+	glBufferData(GL_ARRAY_BUFFER, lineBytes + triBytes + circleBytes, nullptr, GL_STATIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, lineBytes, sm_singleton->m_2Dlines + sm_singleton->m_layerLineStart);
+	glBufferSubData(GL_ARRAY_BUFFER, lineBytes, triBytes, sm_singleton->m_2Dtris + sm_singleton->m_layerTriStart);
+	glBufferSubData(GL_ARRAY_BUFFER, lineBytes + triBytes, circleBytes, sm_singleton->m_2Dcircles + sm_singleton->m_layerCircleStart);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	layer.lineVAO = createVAO(layer.vbo, VERTEX_2D_LAYOUT, 0);
+	layer.triVAO = createVAO(layer.vbo, VERTEX_2D_LAYOUT, lineBytes);
+	layer.circleVAO = createVAO(layer.vbo, CIRCLE_LAYOUT, lineBytes + triBytes);
+
+	// reuse a destroyed layer's slot
+	std::vector<Layer2D>& layers = sm_singleton->m_layers;
+	for (unsigned int i = 0; i < layers.size(); ++i) {
+		if (layers[i].vbo == 0) {
+			layers[i] = layer;
+			return i + 1;
+		}
+	}
+	layers.push_back(layer);
+	return (unsigned int)layers.size();
+}
+
+void Gizmos::draw2DLayer(unsigned int layer, const glm::mat4& projection) {
+	if (sm_singleton == nullptr || layer == 0 || layer > sm_singleton->m_layers.size() ||
+		sm_singleton->m_layers[layer - 1].vbo == 0)
+		return;
+
+	const Layer2D& source = sm_singleton->m_layers[layer - 1];
+	Batch2D batch = {};
+	batch.lineVAO = source.lineVAO;
+	batch.lineCount = source.lineCount * 2;
+	batch.triVAO = source.triVAO;
+	batch.triCount = source.triCount * 3;
+	batch.circleVAO = source.circleVAO;
+	batch.circleCount = source.circleCount;
+	sm_singleton->drawBatch2D(batch, projection);
+}
+
+void Gizmos::destroy2DLayer(unsigned int layer) {
+	if (sm_singleton == nullptr || layer == 0 || layer > sm_singleton->m_layers.size())
+		return;
+
+	Layer2D& target = sm_singleton->m_layers[layer - 1];
+	if (target.vbo != 0) {
+		glDeleteBuffers(1, &target.vbo);
+		glDeleteVertexArrays(1, &target.lineVAO);
+		glDeleteVertexArrays(1, &target.triVAO);
+		glDeleteVertexArrays(1, &target.circleVAO);
+		target.vbo = 0;
+	}
 }
 
 // Adds 3 unit-length lines (red,green,blue) representing the 3 axis of a transform, 
@@ -711,7 +1008,8 @@ void Gizmos::addLine(const glm::vec3& v0,  const glm::vec3& v1, const glm::vec4&
 void Gizmos::addLine(const glm::vec3& v0, const glm::vec3& v1, const glm::vec4& colour0, const glm::vec4& colour1) {
 
 	if (sm_singleton != nullptr &&
-		sm_singleton->m_lineCount < sm_singleton->m_maxLines) {
+		(sm_singleton->m_lineCount < sm_singleton->m_maxLines ||
+		 sm_singleton->grow(sm_singleton->m_lineStream, sm_singleton->m_maxLines, sm_singleton->m_lineCount, sizeof(GizmoLine), sm_singleton->m_stats.lines))) {
 		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.x = v0.x;
 		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.y = v0.y;
 		sm_singleton->m_lines[sm_singleton->m_lineCount].v0.z = v0.z;
@@ -737,7 +1035,8 @@ void Gizmos::addLine(const glm::vec3& v0, const glm::vec3& v1, const glm::vec4&
 void Gizmos::addTri(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const glm::vec4& colour) {
 	if (sm_singleton != nullptr) {
 		if (colour.w == 1) {
-			if (sm_singleton->m_triCount < sm_singleton->m_maxTris) {
+			if (sm_singleton->m_triCount < sm_singleton->m_maxTris ||
+				sm_singleton->grow(sm_singleton->m_triStream, sm_singleton->m_maxTris, sm_singleton->m_triCount, sizeof(GizmoTri), sm_singleton->m_stats.tris)) {
 				sm_singleton->m_tris[sm_singleton->m_triCount].v0.x = v0.x;
 				sm_singleton->m_tris[sm_singleton->m_triCount].v0.y = v0.y;
 				sm_singleton->m_tris[sm_singleton->m_triCount].v0.z = v0.z;
@@ -768,7 +1067,8 @@ void Gizmos::addTri(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v
 			}
 		}
 		else {
-			if (sm_singleton->m_transparentTriCount < sm_singleton->m_maxTris) {
+			if (sm_singleton->m_transparentTriCount < sm_singleton->m_maxTransparentTris ||
+				sm_singleton->grow(sm_singleton->m_transparentTriStream, sm_singleton->m_maxTransparentTris, sm_singleton->m_transparentTriCount, sizeof(GizmoTri), sm_singleton->m_stats.transparentTris)) {
 				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.x = v0.x;
 				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.y = v0.y;
 				sm_singleton->m_transparentTris[sm_singleton->m_transparentTriCount].v0.z = v0.z;
@@ -867,29 +1167,46 @@ void Gizmos::add2DCircle(const glm::vec2& center, float radius, unsigned int seg
 	}
 }
 
+void Gizmos::add2DCircleFilled(const glm::vec2& center, float radius, const glm::vec4& colour) {
+	if (sm_singleton != nullptr &&
+		(sm_singleton->m_2DcircleCount < sm_singleton->m_max2DCircles ||
+		 sm_singleton->grow(sm_singleton->m_2DcircleStream, sm_singleton->m_max2DCircles, sm_singleton->m_2DcircleCount, sizeof(GizmoCircle), sm_singleton->m_stats.circles2D))) {
+		GizmoCircle& circle = sm_singleton->m_2Dcircles[sm_singleton->m_2DcircleCount++];
+		circle.x = center.x;
+		circle.y = center.y;
+		circle.radius = radius;
+		circle.r = colour.r;
+		circle.g = colour.g;
+		circle.b = colour.b;
+		circle.a = colour.a;
+	}
+}
+
+// converts a 0-1 colour channel to 0-255, rounding to nearest
+static inline unsigned char packChannel(float channel) {
+	return (unsigned char)(std::min(std::max(channel, 0.f), 1.f) * 255.f + 0.5f);
+}
+
+void Gizmos::set2DVertex(Gizmo2DVertex& vertex, const glm::vec2& position, const glm::vec4& colour) {
+	vertex.x = position.x;
+	vertex.y = position.y;
+	vertex.r = packChannel(colour.r);
+	vertex.g = packChannel(colour.g);
+	vertex.b = packChannel(colour.b);
+	vertex.a = packChannel(colour.a);
+}
+
 void Gizmos::add2DLine(const glm::vec2& rv0,  const glm::vec2& rv1, const glm::vec4& colour) {
 	add2DLine(rv0,rv1,colour,colour);
 }
 
 void Gizmos::add2DLine(const glm::vec2& rv0, const glm::vec2& rv1, const glm::vec4& colour0, const glm::vec4& colour1) {
 	if (sm_singleton != nullptr &&
-		sm_singleton->m_2DlineCount < sm_singleton->m_max2DLines) {
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.x = rv0.x;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.y = rv0.y;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.z = 1;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.w = 1;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.r = colour0.r;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.g = colour0.g;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.b = colour0.b;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v0.a = colour0.a;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.x = rv1.x;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.y = rv1.y;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.z = 1;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.w = 1;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.r = colour1.r;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.g = colour1.g;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.b = colour1.b;
-		sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount].v1.a = colour1.a;
+		(sm_singleton->m_2DlineCount < sm_singleton->m_max2DLines ||
+		 sm_singleton->grow(sm_singleton->m_2DlineStream, sm_singleton->m_max2DLines, sm_singleton->m_2DlineCount, sizeof(Gizmo2DLine), sm_singleton->m_stats.lines2D))) {
+		Gizmo2DLine& line = sm_singleton->m_2Dlines[sm_singleton->m_2DlineCount];
+		set2DVertex(line.v0, rv0, colour0);
+		set2DVertex(line.v1, rv1, colour1);
 
 		sm_singleton->m_2DlineCount++;
 	}
@@ -901,31 +1218,12 @@ void Gizmos::add2DTri(const glm::vec2& rv0, const glm::vec2& rv1, const glm::vec
 
 void Gizmos::add2DTri(const glm::vec2& rv0, const glm::vec2& rv1, const glm::vec2& rv2, const glm::vec4& colour0, const glm::vec4& colour1, const glm::vec4& colour2) {
 	if (sm_singleton != nullptr) {
-		if (sm_singleton->m_2DtriCount < sm_singleton->m_max2DTris) {
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.x = rv0.x;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.y = rv0.y;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.z = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.w = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.x = rv1.x;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.y = rv1.y;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.z = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.w = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.x = rv2.x;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.y = rv2.y;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.z = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.w = 1;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.r = colour0.r;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.g = colour0.g;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.b = colour0.b;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v0.a = colour0.a;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.r = colour1.r;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.g = colour1.g;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.b = colour1.b;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v1.a = colour1.a;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.r = colour2.r;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.g = colour2.g;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.b = colour2.b;
-			sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount].v2.a = colour2.a;
+		if (sm_singleton->m_2DtriCount < sm_singleton->m_max2DTris ||
+			sm_singleton->grow(sm_singleton->m_2DtriStream, sm_singleton->m_max2DTris, sm_singleton->m_2DtriCount, sizeof(Gizmo2DTri), sm_singleton->m_stats.tris2D)) {
+			Gizmo2DTri& tri = sm_singleton->m_2Dtris[sm_singleton->m_2DtriCount];
+			set2DVertex(tri.v0, rv0, colour0);
+			set2DVertex(tri.v1, rv1, colour1);
+			set2DVertex(tri.v2, rv2, colour2);
 
 			sm_singleton->m_2DtriCount++;
 		}
@@ -950,19 +1248,17 @@ void Gizmos::draw(const glm::mat4& projectionView) {
 		glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(projectionView));
 
 		if (sm_singleton->m_lineCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_lineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_lineCount * sizeof(GizmoLine), sm_singleton->m_lines);
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_lineStream, sm_singleton->m_lineCount * sizeof(GizmoLine), sm_singleton->m_stats.lines);
 
-			glBindVertexArray(sm_singleton->m_lineVAO);
-			glDrawArrays(GL_LINES, 0, sm_singleton->m_lineCount * 2);
+			glBindVertexArray(sm_singleton->m_lineStream.vao);
+			glDrawArrays(GL_LINES, (GLint)(offset / sizeof(GizmoVertex)), sm_singleton->m_lineCount * 2);
 		}
 
 		if (sm_singleton->m_triCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_triVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_triCount * sizeof(GizmoTri), sm_singleton->m_tris);
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_triStream, sm_singleton->m_triCount * sizeof(GizmoTri), sm_singleton->m_stats.tris);
 
-			glBindVertexArray(sm_singleton->m_triVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_triCount * 3);
+			glBindVertexArray(sm_singleton->m_triStream.vao);
+			glDrawArrays(GL_TRIANGLES, (GLint)(offset / sizeof(GizmoVertex)), sm_singleton->m_triCount * 3);
 		}
 		
 		if (sm_singleton->m_transparentTriCount > 0) {
@@ -981,11 +1277,10 @@ void Gizmos::draw(const glm::mat4& projectionView) {
 			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 			glDepthMask(GL_FALSE);
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_transparentTriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_transparentTriCount * sizeof(GizmoTri), sm_singleton->m_transparentTris);
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_transparentTriStream, sm_singleton->m_transparentTriCount * sizeof(GizmoTri), sm_singleton->m_stats.transparentTris);
 
-			glBindVertexArray(sm_singleton->m_transparentTriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_transparentTriCount * 3);
+			glBindVertexArray(sm_singleton->m_transparentTriStream.vao);
+			glDrawArrays(GL_TRIANGLES, (GLint)(offset / sizeof(GizmoVertex)), sm_singleton->m_transparentTriCount * 3);
 
 			// reset state
 			glDepthMask(depthMask);
@@ -995,6 +1290,8 @@ void Gizmos::draw(const glm::mat4& projectionView) {
 		}
 
 		glUseProgram(shader);
+
+		sm_singleton->fenceFrame();
 	}
 }
 
@@ -1005,56 +1302,100 @@ void Gizmos::draw2D(float screenWidth, float screenHeight) {
 void Gizmos::draw2D(const glm::mat4& projection) {
 	if ( sm_singleton != nullptr && 
 		(sm_singleton->m_2DlineCount > 0 || 
-		 sm_singleton->m_2DtriCount > 0)) {
-		int shader = 0;
-		glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
-
-		glUseProgram(sm_singleton->m_shader);
-		
-		unsigned int projectionViewUniform = glGetUniformLocation(sm_singleton->m_shader,"ProjectionView");
-		glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(projection));
+		 sm_singleton->m_2DtriCount > 0 ||
+		 sm_singleton->m_2DcircleCount > 0)) {
+		Batch2D batch = {};
 
 		if (sm_singleton->m_2DlineCount > 0) {
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_2DlineVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_2DlineCount * sizeof(GizmoLine), sm_singleton->m_2Dlines);
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_2DlineStream, sm_singleton->m_2DlineCount * sizeof(Gizmo2DLine), sm_singleton->m_stats.lines2D);
 
-			glBindVertexArray(sm_singleton->m_2DlineVAO);
-			glDrawArrays(GL_LINES, 0, sm_singleton->m_2DlineCount * 2);
+			batch.lineVAO = sm_singleton->m_2DlineStream.vao;
+			batch.lineFirst = (unsigned int)(offset / sizeof(Gizmo2DVertex));
+			batch.lineCount = sm_singleton->m_2DlineCount * 2;
 		}
 
 		if (sm_singleton->m_2DtriCount > 0) {
-			GLboolean blendEnabled = glIsEnabled(GL_BLEND);
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_2DtriStream, sm_singleton->m_2DtriCount * sizeof(Gizmo2DTri), sm_singleton->m_stats.tris2D);
 
-			GLboolean depthMask = GL_TRUE;
-			glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+			batch.triVAO = sm_singleton->m_2DtriStream.vao;
+			batch.triFirst = (unsigned int)(offset / sizeof(Gizmo2DVertex));
+			batch.triCount = sm_singleton->m_2DtriCount * 3;
+		}
 
-			int src, dst;
-			glGetIntegerv(GL_BLEND_SRC, &src);
-			glGetIntegerv(GL_BLEND_DST, &dst);
+		if (sm_singleton->m_2DcircleCount > 0) {
+			size_t offset = sm_singleton->uploadStream(sm_singleton->m_2DcircleStream, sm_singleton->m_2DcircleCount * sizeof(GizmoCircle), sm_singleton->m_stats.circles2D);
 
-			if (blendEnabled == GL_FALSE)
-				glEnable(GL_BLEND);
+			batch.circleVAO = sm_singleton->m_2DcircleStream.vao;
+			batch.circleFirst = (unsigned int)(offset / sizeof(GizmoCircle));
+			batch.circleCount = sm_singleton->m_2DcircleCount;
+		}
 
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		sm_singleton->drawBatch2D(batch, projection);
 
-			glDepthMask(GL_FALSE);
+		sm_singleton->fenceFrame();
+	}
+}
 
-			glBindBuffer(GL_ARRAY_BUFFER, sm_singleton->m_2DtriVBO);
-			glBufferSubData(GL_ARRAY_BUFFER, 0, sm_singleton->m_2DtriCount * sizeof(GizmoTri), sm_singleton->m_2Dtris);
+void Gizmos::drawBatch2D(const Batch2D& batch, const glm::mat4& projection) {
+	int shader = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &shader);
 
-			glBindVertexArray(sm_singleton->m_2DtriVAO);
-			glDrawArrays(GL_TRIANGLES, 0, sm_singleton->m_2DtriCount * 3);
+	glUseProgram(m_2Dshader);
+	
+	unsigned int projectionViewUniform = glGetUniformLocation(m_2Dshader,"ProjectionView");
+	glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(projection));
 
-			glDepthMask(depthMask);
+	if (batch.lineCount > 0) {
+		glBindVertexArray(batch.lineVAO);
+		glDrawArrays(GL_LINES, batch.lineFirst, batch.lineCount);
+	}
 
-			glBlendFunc(src, dst);
+	if (batch.triCount > 0 || batch.circleCount > 0) {
+		GLboolean blendEnabled = glIsEnabled(GL_BLEND);
 
-			if (blendEnabled == GL_FALSE)
-				glDisable(GL_BLEND);
+		GLboolean depthMask = GL_TRUE;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+
+		int src, dst;
+		glGetIntegerv(GL_BLEND_SRC, &src);
+		glGetIntegerv(GL_BLEND_DST, &dst);
+
+		if (blendEnabled == GL_FALSE)
+			glEnable(GL_BLEND);
+
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+		glDepthMask(GL_FALSE);
+
+		if (batch.triCount > 0) {
+			glBindVertexArray(batch.triVAO);
+			glDrawArrays(GL_TRIANGLES, batch.triFirst, batch.triCount);
 		}
 
-		glUseProgram(shader);
+		// filled circles: one quad per circle, 4 vertices per instance
+		if (batch.circleCount > 0) {
+			glUseProgram(m_circleShader);
+
+			projectionViewUniform = glGetUniformLocation(m_circleShader,"ProjectionView");
+			glUniformMatrix4fv(projectionViewUniform, 1, false, glm::value_ptr(projection));
+
+			// instance attributes start at the base instance, so a region's circles are picked out with it
+			glBindVertexArray(batch.circleVAO);
+			if (batch.circleFirst > 0)
+				glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, batch.circleCount, batch.circleFirst);
+			else
+				glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, batch.circleCount);
+		}
+
+		glDepthMask(depthMask);
+
+		glBlendFunc(src, dst);
+
+		if (blendEnabled == GL_FALSE)
+			glDisable(GL_BLEND);
 	}
+
+	glUseProgram(shader);
 }
 
 } // namespace aie
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <glm/fwd.hpp>
+#include <cstddef>
+#include <vector>
 
 namespace aie {
 
@@ -8,8 +10,10 @@ namespace aie {
 class Gizmos {
 public:
 
+	// the maximums are starting capacities; lists grow past them as needed (see setCapacityLimit)
 	static void		create(unsigned int maxLines, unsigned int maxTris,
-						   unsigned int max2DLines, unsigned int max2DTris);
+						   unsigned int max2DLines, unsigned int max2DTris,
+						   unsigned int max2DCircles = 4096);
 	static void		destroy();
 
 	// removes all Gizmos
@@ -90,11 +94,51 @@ public:
 	static void		add2DAABB(const glm::vec2& center, const glm::vec2& extents, const glm::vec4& colour, const glm::mat4* transform = nullptr);	
 	static void		add2DAABBFilled(const glm::vec2& center, const glm::vec2& extents, const glm::vec4& colour, const glm::mat4* transform = nullptr);	
 	static void		add2DCircle(const glm::vec2& center, float radius, unsigned int segments, const glm::vec4& colour, const glm::mat4* transform = nullptr);
+
+	// adds a filled circle as a single instanced quad; the fragment shader cuts out the circle with an anti-aliased edge.
+	// far cheaper than add2DCircle for many circles. filled circles are drawn after the 2D triangles, in the order added
+	static void		add2DCircleFilled(const glm::vec2& center, float radius, const glm::vec4& colour);
+
+	// static layers keep 2D gizmos that never change in a buffer of their own, so they are uploaded once rather than
+	// every frame. the 2D gizmos added between begin2DLayer and end2DLayer go into the layer instead of this frame
+	static void		begin2DLayer();
+	// returns the new layer, or 0 if nothing was added
+	static unsigned int	end2DLayer();
+	// draws a layer like draw2D does: lines, then triangles, then filled circles.
+	// draw layers before draw2D to keep them underneath the frame's gizmos
+	static void		draw2DLayer(unsigned int layer, const glm::mat4& projection);
+	static void		destroy2DLayer(unsigned int layer);
+
+	// usage of one primitive list. a list starts at the capacity given to create and doubles whenever it fills,
+	// up to the capacity limit; only primitives added past the limit are dropped
+	struct ListStats {
+		unsigned int	submitted;		// primitives added since the last clear, including dropped ones
+		unsigned int	dropped;		// primitives discarded since the last clear because the list was at the limit
+		unsigned int	highWater;		// most primitives the list has held in one frame since create
+		unsigned int	capacity;		// primitives the list holds before it next grows
+		size_t			bytesUploaded;	// bytes handed to the GPU for the list by the draws since the last clear
+	};
+
+	struct Stats {
+		ListStats		lines;
+		ListStats		tris;
+		ListStats		transparentTris;
+		ListStats		lines2D;
+		ListStats		tris2D;
+		ListStats		circles2D;
+	};
+
+	// gets the usage of every list so far this frame; call it before clear to get the whole of the last frame
+	static Stats	getStats();
+
+	// sets the most primitives any one list may grow to (1048576 by default)
+	static void		setCapacityLimit(unsigned int limit);
 	
 private:
 
 	Gizmos(unsigned int maxLines, unsigned int maxTris,
-		   unsigned int max2DLines, unsigned int max2DTris);
+		   unsigned int max2DLines, unsigned int max2DTris,
+		   unsigned int max2DCircles);
 	~Gizmos();
 
 	struct GizmoVertex {
@@ -113,45 +157,152 @@ private:
 		GizmoVertex v2;
 	};
 
+	// 2D vertices leave out z and w, which are always 1, and pack the colour into 8 bits per channel
+	struct Gizmo2DVertex {
+		float x, y;
+		unsigned char r, g, b, a;
+	};
+
+	struct Gizmo2DLine {
+		Gizmo2DVertex v0;
+		Gizmo2DVertex v1;
+	};
+
+	struct Gizmo2DTri {
+		Gizmo2DVertex v0;
+		Gizmo2DVertex v1;
+		Gizmo2DVertex v2;
+	};
+
+	// per-instance data of a filled circle
+	struct GizmoCircle {
+		float x, y, radius;
+		float r, g, b, a;
+	};
+
+	// how a VAO reads its buffer
+	enum VertexLayout {
+		VERTEX_LAYOUT,	// GizmoVertex per vertex
+		VERTEX_2D_LAYOUT,	// Gizmo2DVertex per vertex
+		CIRCLE_LAYOUT,	// GizmoCircle per instance
+	};
+
+	// frames the streaming buffers keep in flight: the CPU fills one region while the GPU may still read the others
+	static const unsigned int sm_regionCount = 3;
+
+	// vertex buffer for one primitive list, streamed to the GPU without staging copies or implicit synchronisation.
+	// with GL 4.4 the buffer is created with glBufferStorage and stays persistently mapped, split into one region
+	// per frame in flight, and gizmos are written straight into the current frame's region.
+	// without it the buffer falls back to a CPU array uploaded with glBufferSubData
+	struct StreamBuffer {
+		unsigned int	vbo;
+		unsigned int	vao;
+		VertexLayout	layout;
+		unsigned char*	memory;		// mapping of every region, or the CPU array when not persistent
+		size_t			regionSize;	// bytes in one region
+		bool			persistent;	// whether memory is a persistent mapping
+	};
+
+	// creates a stream with regions of regionSize bytes, and a VAO reading it with the given layout
+	void			createStream(StreamBuffer& stream, size_t regionSize, VertexLayout layout);
+	void			destroyStream(StreamBuffer& stream);
+	// moves a full list's stream to a new buffer with twice the capacity, keeping the count primitives written this frame.
+	// returns false, counting a dropped primitive, if the list is already at the capacity limit
+	bool			grow(StreamBuffer& stream, unsigned int& maxPrimitives, unsigned int count, size_t primitiveSize, ListStats& stats);
+	// gets where the current frame's data starts in a stream's memory
+	unsigned char*	streamRegion(const StreamBuffer& stream) const;
+	// makes the first bytes of the current frame's data visible to the GPU, returning their offset in the buffer
+	size_t			uploadStream(const StreamBuffer& stream, size_t bytes, ListStats& stats);
+	// moves every stream on to the next region, waiting until the GPU has finished reading it
+	void			beginFrame();
+	// points every primitive list at its stream's current region
+	void			pointLists();
+	// marks the current region as in use by the draw calls issued so far
+	void			fenceFrame();
+
+	// creates a VAO reading vbo with a layout, starting offset bytes in
+	static unsigned int	createVAO(unsigned int vbo, VertexLayout layout, size_t offset);
+
+	// a static 2D layer, with each kind of primitive after the last in one buffer
+	struct Layer2D {
+		unsigned int	vbo;		// 0 for a free slot
+		unsigned int	lineVAO, triVAO, circleVAO;
+		unsigned int	lineCount, triCount, circleCount;
+	};
+
+	// 2D primitives for one draw
+	struct Batch2D {
+		unsigned int	lineVAO, lineFirst, lineCount;			// first and count in vertices
+		unsigned int	triVAO, triFirst, triCount;				// first and count in vertices
+		unsigned int	circleVAO, circleFirst, circleCount;	// first and count in instances
+	};
+
+	// draws 2D primitives with the 2D shaders, saving and restoring the GL state it changes
+	void			drawBatch2D(const Batch2D& batch, const glm::mat4& projection);
+
+	// fills a packed 2D vertex, rounding the colour to 8 bits per channel
+	static void		set2DVertex(Gizmo2DVertex& vertex, const glm::vec2& position, const glm::vec4& colour);
+
 	unsigned int	m_shader;
+	unsigned int	m_2Dshader;
+	unsigned int	m_circleShader;
 
 	// line data
 	unsigned int	m_maxLines;
 	unsigned int	m_lineCount;
 	GizmoLine*		m_lines;
 
-	unsigned int	m_lineVAO;
-	unsigned int 	m_lineVBO;
+	StreamBuffer	m_lineStream;
 
 	// triangle data
 	unsigned int	m_maxTris;
 	unsigned int	m_triCount;
 	GizmoTri*		m_tris;
 
-	unsigned int	m_triVAO;
-	unsigned int 	m_triVBO;
+	StreamBuffer	m_triStream;
 	
+	unsigned int	m_maxTransparentTris;
 	unsigned int	m_transparentTriCount;
 	GizmoTri*		m_transparentTris;
 
-	unsigned int	m_transparentTriVAO;
-	unsigned int 	m_transparentTriVBO;
+	StreamBuffer	m_transparentTriStream;
 	
 	// 2D line data
 	unsigned int	m_max2DLines;
 	unsigned int	m_2DlineCount;
-	GizmoLine*		m_2Dlines;
+	Gizmo2DLine*	m_2Dlines;
 
-	unsigned int	m_2DlineVAO;
-	unsigned int 	m_2DlineVBO;
+	StreamBuffer	m_2DlineStream;
 
 	// 2D triangle data
 	unsigned int	m_max2DTris;
 	unsigned int	m_2DtriCount;
-	GizmoTri*		m_2Dtris;
+	Gizmo2DTri*		m_2Dtris;
+
+	StreamBuffer	m_2DtriStream;
+
+	// 2D filled circle data
+	unsigned int	m_max2DCircles;
+	unsigned int	m_2DcircleCount;
+	GizmoCircle*	m_2Dcircles;
+
+	StreamBuffer	m_2DcircleStream;
+
+	// streaming state
+	bool			m_persistent;	// whether GL 4.4 buffer storage, fences and base-instance draws are available
+	unsigned int	m_region;		// region of every stream written this frame
+	void*			m_fences[sm_regionCount];	// fence (a GLsync) after the last draw reading each region
+
+	// list growth and usage
+	unsigned int	m_capacityLimit;
+	Stats			m_stats;	// dropped, highWater and bytesUploaded of each list
 
-	unsigned int	m_2DtriVAO;
-	unsigned int 	m_2DtriVBO;
+	// static 2D layers, indexed by layer - 1
+	std::vector<Layer2D>	m_layers;
+	bool			m_recordingLayer;
+	unsigned int	m_layerLineStart;	// 2D list counts when the layer being recorded began
+	unsigned int	m_layerTriStart;
+	unsigned int	m_layerCircleStart;
 
 	static Gizmos*	sm_singleton;
 };